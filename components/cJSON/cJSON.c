@@ -44,11 +44,24 @@
 #include <limits.h>
 #include <ctype.h>
 #include <float.h>
+#include <stdint.h>
 
 #ifdef ENABLE_LOCALES
 #include <locale.h>
 #endif
 
+/* CJSON_ENABLE_SWAR scans strings and whitespace a word at a time once a run is longer than CJSON_SCAN_PREFIX, plus an
+ * SSE2 variant on hosts that have it (there is no byte SIMD usable from C on Xtensa). It pays off for long strings
+ * (log text) only; on telemetry and peer documents, where nearly every string is short, tools/bench/bench_scan shows
+ * no gain over the byte loop, so it is off by default */
+#if defined(CJSON_ENABLE_SWAR)
+#define CJSON_SCAN_WORDS
+#endif
+#if defined(__SSE2__) && !defined(CJSON_DISABLE_SIMD) && defined(CJSON_SCAN_WORDS)
+#define CJSON_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
 #if defined(_MSC_VER)
 #pragma warning (pop)
 #endif
@@ -293,8 +306,81 @@ typedef struct
     size_t offset;
     size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
     internal_hooks hooks;
+    cJSON_Arena *arena; /* if set, nodes and strings are carved out of this arena instead of the hooks */
+    cJSON_bool in_situ; /* strings are unescaped inside content, which is writable then */
 } parse_buffer;
 
+static void* cast_away_const(const void* string);
+
+/* bump allocate size bytes with the given (power of two) alignment, NULL if the arena is exhausted */
+static void *arena_allocate(cJSON_Arena * const arena, size_t size, size_t alignment)
+{
+    unsigned char *memory = NULL;
+    size_t padding = 0;
+
+    if ((arena == NULL) || (arena->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    padding = (alignment - ((size_t)(arena->buffer + arena->used) & (alignment - 1))) & (alignment - 1);
+    if ((arena->used + padding > arena->size) || (size > (arena->size - arena->used - padding)))
+    {
+        return NULL;
+    }
+
+    memory = arena->buffer + arena->used + padding;
+    arena->used += padding + size;
+
+    return memory;
+}
+
+/* allocation helpers for the parser, these honour an arena if the parse is arena backed */
+static unsigned char *parse_allocate_string(parse_buffer * const input_buffer, size_t size)
+{
+    if (input_buffer->arena != NULL)
+    {
+        return (unsigned char*)arena_allocate(input_buffer->arena, size, 1);
+    }
+
+    return (unsigned char*)input_buffer->hooks.allocate(size);
+}
+
+static void parse_deallocate_string(parse_buffer * const input_buffer, unsigned char *string)
+{
+    /* arena memory is only released as a whole */
+    if (input_buffer->arena == NULL)
+    {
+        input_buffer->hooks.deallocate(string);
+    }
+}
+
+static cJSON *parse_new_item(parse_buffer * const input_buffer)
+{
+    cJSON *node = NULL;
+
+    if (input_buffer->arena == NULL)
+    {
+        return cJSON_New_Item(&(input_buffer->hooks));
+    }
+
+    node = (cJSON*)arena_allocate(input_buffer->arena, sizeof(cJSON), CJSON_ARENA_ALIGNMENT);
+    if (node)
+    {
+        memset(node, '\0', sizeof(cJSON));
+    }
+
+    return node;
+}
+
+static void parse_delete_items(parse_buffer * const input_buffer, cJSON *items)
+{
+    if (input_buffer->arena == NULL)
+    {
+        cJSON_Delete(items);
+    }
+}
+
 /* check if the given size is left to read in a given parse buffer (starting with 1) */
 #define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
 /* check if the buffer can be accessed at the given index (starting with 0) */
@@ -303,13 +389,136 @@ typedef struct
 /* get a pointer to the buffer at the position */
 #define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
+/* powers of ten that are exactly representable as a double */
+static const double exact_powers_of_ten[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define MAX_EXACT_POWER_OF_TEN 22
+#define MAX_EXACT_INTEGER (UINT64_C(1) << 53)
+
+/* Locale independent fast path of parse_number.
+ * The significant digits are collected into an integer that is then scaled by one exact power of ten. As long as
+ * that integer fits into the mantissa of a double the single multiplication or division is correctly rounded, so the
+ * result is the same strtod would give. This covers integers and sensor readings like 21.37 or -0.5e3.
+ * Returns the number of bytes consumed or 0 if the input has to go through strtod. */
+static size_t parse_number_fast(const unsigned char * const input, const size_t length, double * const number)
+{
+    uint64_t significand = 0;
+    size_t significant_digits = 0;
+    int exponent = 0;
+    int explicit_exponent = 0;
+    cJSON_bool negative = false;
+    cJSON_bool exponent_negative = false;
+    double value = 0;
+    size_t i = 0;
+
+    if ((i < length) && (input[i] == '-'))
+    {
+        negative = true;
+        i++;
+    }
+
+    if ((i >= length) || (input[i] < '0') || (input[i] > '9'))
+    {
+        return 0;
+    }
+
+    for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
+    {
+        if (significant_digits == 19)
+        {
+            return 0;
+        }
+        significand = (significand * 10) + (uint64_t)(input[i] - '0');
+        if (significand != 0)
+        {
+            significant_digits++;
+        }
+    }
+
+    if ((i < length) && (input[i] == '.'))
+    {
+        i++;
+        /* leave "1." and similar to strtod */
+        if ((i >= length) || (input[i] < '0') || (input[i] > '9'))
+        {
+            return 0;
+        }
+        for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
+        {
+            if (significant_digits == 19)
+            {
+                return 0;
+            }
+            significand = (significand * 10) + (uint64_t)(input[i] - '0');
+            if (significand != 0)
+            {
+                significant_digits++;
+            }
+            exponent--;
+        }
+    }
+
+    if ((i < length) && ((input[i] == 'e') || (input[i] == 'E')))
+    {
+        i++;
+        if ((i < length) && ((input[i] == '+') || (input[i] == '-')))
+        {
+            exponent_negative = (input[i] == '-');
+            i++;
+        }
+        if ((i >= length) || (input[i] < '0') || (input[i] > '9'))
+        {
+            return 0;
+        }
+        for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
+        {
+            if (explicit_exponent > 1000)
+            {
+                return 0;
+            }
+            explicit_exponent = (explicit_exponent * 10) + (input[i] - '0');
+        }
+        exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+    }
+
+    if (significand > MAX_EXACT_INTEGER)
+    {
+        return 0;
+    }
+
+    value = (double)significand;
+    if ((significand == 0) || (exponent == 0))
+    {
+        /* nothing to scale */
+    }
+    else if ((exponent > 0) && (exponent <= MAX_EXACT_POWER_OF_TEN))
+    {
+        value *= exact_powers_of_ten[exponent];
+    }
+    else if ((exponent < 0) && (exponent >= -MAX_EXACT_POWER_OF_TEN))
+    {
+        value /= exact_powers_of_ten[-exponent];
+    }
+    else
+    {
+        return 0;
+    }
+
+    *number = negative ? -value : value;
+
+    return i;
+}
+
 /* Parse the input text to generate a number, and populate the result into item. */
 static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
 {
     double number = 0;
     unsigned char *after_end = NULL;
     unsigned char number_c_string[64];
-    unsigned char decimal_point = get_decimal_point();
+    unsigned char decimal_point = 0;
     size_t i = 0;
 
     if ((input_buffer == NULL) || (input_buffer->content == NULL))
@@ -317,6 +526,15 @@ static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_bu
         return false;
     }
 
+    i = parse_number_fast(buffer_at_offset(input_buffer), input_buffer->length - input_buffer->offset, &number);
+    if (i > 0)
+    {
+        input_buffer->offset += i;
+        goto number_done;
+    }
+
+    decimal_point = get_decimal_point();
+
     /* copy the number into a temporary buffer and replace '.' with the decimal point
      * of the current locale (for strtod)
      * This also takes care of '\0' not necessarily being available for marking the end of the input */
@@ -357,7 +575,9 @@ loop_end:
     {
         return false; /* parse_error */
     }
+    input_buffer->offset += (size_t)(after_end - number_c_string);
 
+number_done:
     item->valuedouble = number;
 
     /* use saturation in case of overflow */
@@ -376,7 +596,6 @@ loop_end:
 
     item->type = cJSON_Number;
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
     return true;
 }
 
@@ -399,6 +618,41 @@ CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
     return object->valuedouble = number;
 }
 
+CJSON_PUBLIC(cJSON_bool) cJSON_SetNumberPrecision(cJSON *item, int decimals)
+{
+    cJSON *child = NULL;
+    int bits = 0;
+
+    if ((item == NULL) || (decimals > CJSON_MAX_PRECISION))
+    {
+        return false;
+    }
+
+    /* 0 means shortest round trip, otherwise the number of decimals + 1 */
+    bits = (decimals < 0) ? 0 : ((decimals + 1) << cJSON_PrecisionShift);
+
+    if (cJSON_IsNumber(item))
+    {
+        item->type = (item->type & ~cJSON_PrecisionMask) | bits;
+        return true;
+    }
+
+    if (!cJSON_IsArray(item) && !cJSON_IsObject(item))
+    {
+        return false;
+    }
+
+    for (child = item->child; child != NULL; child = child->next)
+    {
+        if (cJSON_IsNumber(child))
+        {
+            child->type = (child->type & ~cJSON_PrecisionMask) | bits;
+        }
+    }
+
+    return true;
+}
+
 /* Note: when passing a NULL valuestring, cJSON_SetValuestring treats this as an error and return NULL */
 CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
 {
@@ -441,8 +695,23 @@ typedef struct
     cJSON_bool noalloc;
     cJSON_bool format; /* is this print a formatted print */
     internal_hooks hooks;
+    cJSON_PrintSink sink; /* if set, buffer is a fixed scratch buffer that is flushed here whenever it is full */
+    void *sink_user_data;
 } printbuffer;
 
+/* hand the rendered part of a sink backed printbuffer to the sink and start over at the beginning */
+static cJSON_bool flush_printbuffer(printbuffer * const p)
+{
+    if ((p->offset > 0) && !p->sink((const char*)p->buffer, p->offset, p->sink_user_data))
+    {
+        return false;
+    }
+    p->offset = 0;
+    p->buffer[0] = '\0';
+
+    return true;
+}
+
 /* realloc printbuffer if necessary to have at least "needed" bytes more */
 static unsigned char* ensure(printbuffer * const p, size_t needed)
 {
@@ -454,9 +723,9 @@ static unsigned char* ensure(printbuffer * const p, size_t needed)
         return NULL;
     }
 
-    if ((p->length > 0) && (p->offset >= p->length))
+    if ((p->length > 0) && (p->offset > p->length))
     {
-        /* make sure that offset is valid */
+        /* make sure that offset is valid, it is at the very end after an unterminated write that filled the buffer */
         return NULL;
     }
 
@@ -466,12 +735,23 @@ static unsigned char* ensure(printbuffer * const p, size_t needed)
         return NULL;
     }
 
-    needed += p->offset + 1;
+    /* needed already counts the terminator, so a buffer of exactly cJSON_PrintLength() + 1 bytes is enough */
+    needed += p->offset;
     if (needed <= p->length)
     {
         return p->buffer + p->offset;
     }
 
+    if (p->sink != NULL)
+    {
+        needed -= p->offset;
+        if ((needed > p->length) || !flush_printbuffer(p))
+        {
+            return NULL;
+        }
+        return p->buffer;
+    }
+
     if (p->noalloc) {
         return NULL;
     }
@@ -549,74 +829,619 @@ static cJSON_bool compare_double(double a, double b)
     return (fabs(a - b) <= maxVal * DBL_EPSILON);
 }
 
-/* Render the number nicely from the given item into a string. */
-static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+/* Shortest round trip formatting of doubles (Grisu2, Loitsch 2010).
+ * The digits are generated with 64 bit integer arithmetic only, there is no sprintf and no reparse. The output always
+ * parses back to the same double and is the shortest such string in all but very rare cases. */
+typedef struct
 {
-    unsigned char *output_pointer = NULL;
-    double d = item->valuedouble;
-    int length = 0;
+    uint64_t f;
+    int e;
+} diy_fp;
+
+#define DIY_SIGNIFICAND_SIZE 64
+#define DOUBLE_SIGNIFICAND_SIZE 52
+#define DOUBLE_HIDDEN_BIT UINT64_C(0x0010000000000000)
+#define DOUBLE_SIGNIFICAND_MASK UINT64_C(0x000FFFFFFFFFFFFF)
+#define DOUBLE_EXPONENT_MASK UINT64_C(0x7FF0000000000000)
+#define DOUBLE_EXPONENT_BIAS (0x3FF + DOUBLE_SIGNIFICAND_SIZE)
+
+/* normalized 64 bit approximations of 10^-348, 10^-340, ..., 10^340 */
+static const uint64_t cached_powers_f[] =
+{
+    UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76), UINT64_C(0x8b16fb203055ac76),
+    UINT64_C(0xcf42894a5dce35ea), UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+    UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f), UINT64_C(0xbe5691ef416bd60c),
+    UINT64_C(0x8dd01fad907ffc3c), UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+    UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d), UINT64_C(0x823c12795db6ce57),
+    UINT64_C(0xc21094364dfb5637), UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+    UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5), UINT64_C(0xb23867fb2a35b28e),
+    UINT64_C(0x84c8d4dfd2c63f3b), UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+    UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6), UINT64_C(0xf3e2f893dec3f126),
+    UINT64_C(0xb5b5ada8aaff80b8), UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+    UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd), UINT64_C(0xa6dfbd9fb8e5b88f),
+    UINT64_C(0xf8a95fcf88747d94), UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+    UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac), UINT64_C(0xe45c10c42a2b3b06),
+    UINT64_C(0xaa242499697392d3), UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+    UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c), UINT64_C(0x9c40000000000000),
+    UINT64_C(0xe8d4a51000000000), UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+    UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70), UINT64_C(0xd5d238a4abe98068),
+    UINT64_C(0x9f4f2726179a2245), UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+    UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a), UINT64_C(0x924d692ca61be758),
+    UINT64_C(0xda01ee641a708dea), UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+    UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2), UINT64_C(0xc83553c5c8965d3d),
+    UINT64_C(0x952ab45cfa97a0b3), UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+    UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece), UINT64_C(0x88fcf317f22241e2),
+    UINT64_C(0xcc20ce9bd35c78a5), UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+    UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c), UINT64_C(0xbb764c4ca7a44410),
+    UINT64_C(0x8bab8eefb6409c1a), UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+    UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429), UINT64_C(0x80444b5e7aa7cf85),
+    UINT64_C(0xbf21e44003acdd2d), UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+    UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9), UINT64_C(0xaf87023b9bf0ee6b)
+};
+static const short cached_powers_e[] =
+{
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066
+};
+
+static const uint32_t powers_of_ten_32[] =
+{
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static diy_fp diy_fp_from_double(double d)
+{
+    diy_fp fp;
+    uint64_t bits = 0;
+    int biased_exponent = 0;
+
+    memcpy(&bits, &d, sizeof(bits));
+    biased_exponent = (int)((bits & DOUBLE_EXPONENT_MASK) >> DOUBLE_SIGNIFICAND_SIZE);
+    fp.f = bits & DOUBLE_SIGNIFICAND_MASK;
+    if (biased_exponent != 0)
+    {
+        fp.f += DOUBLE_HIDDEN_BIT;
+        fp.e = biased_exponent - DOUBLE_EXPONENT_BIAS;
+    }
+    else
+    {
+        fp.e = 1 - DOUBLE_EXPONENT_BIAS;
+    }
+
+    return fp;
+}
+
+static diy_fp diy_fp_multiply(const diy_fp x, const diy_fp y)
+{
+    const uint64_t mask_32 = UINT64_C(0xFFFFFFFF);
+    const uint64_t a = x.f >> 32;
+    const uint64_t b = x.f & mask_32;
+    const uint64_t c = y.f >> 32;
+    const uint64_t d = y.f & mask_32;
+    const uint64_t ac = a * c;
+    const uint64_t bc = b * c;
+    const uint64_t ad = a * d;
+    const uint64_t bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & mask_32) + (bc & mask_32);
+    diy_fp product;
+
+    middle += UINT64_C(1) << 31; /* round */
+    product.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    product.e = x.e + y.e + DIY_SIGNIFICAND_SIZE;
+
+    return product;
+}
+
+static diy_fp diy_fp_normalize(diy_fp fp)
+{
+    while ((fp.f & (UINT64_C(1) << 63)) == 0)
+    {
+        fp.f <<= 1;
+        fp.e--;
+    }
+
+    return fp;
+}
+
+/* the boundaries m- and m+ halfway to the neighbouring doubles, both with the exponent of the normalized m+ */
+static void diy_fp_boundaries(const diy_fp value, diy_fp * const minus, diy_fp * const plus)
+{
+    diy_fp upper;
+    diy_fp lower;
+
+    upper.f = (value.f << 1) + 1;
+    upper.e = value.e - 1;
+    while ((upper.f & (DOUBLE_HIDDEN_BIT << 1)) == 0)
+    {
+        upper.f <<= 1;
+        upper.e--;
+    }
+    upper.f <<= DIY_SIGNIFICAND_SIZE - DOUBLE_SIGNIFICAND_SIZE - 2;
+    upper.e -= DIY_SIGNIFICAND_SIZE - DOUBLE_SIGNIFICAND_SIZE - 2;
+
+    /* the gap below a power of two is half the gap above it */
+    if (value.f == DOUBLE_HIDDEN_BIT)
+    {
+        lower.f = (value.f << 2) - 1;
+        lower.e = value.e - 2;
+    }
+    else
+    {
+        lower.f = (value.f << 1) - 1;
+        lower.e = value.e - 1;
+    }
+    lower.f <<= lower.e - upper.e;
+    lower.e = upper.e;
+
+    *minus = lower;
+    *plus = upper;
+}
+
+/* c_k such that the product with a number of binary exponent e lands in the exponent range -60..-32 */
+static diy_fp cached_power(const int e, int * const decimal_exponent)
+{
+    diy_fp power;
+    double dk = (-61 - e) * 0.30102999566398114 + 347; /* log10(2) */
+    int k = (int)dk;
+    size_t index = 0;
+
+    if ((dk - k) > 0.0)
+    {
+        k++;
+    }
+    index = (size_t)((k >> 3) + 1);
+    *decimal_exponent = -(-348 + (int)(index << 3));
+    power.f = cached_powers_f[index];
+    power.e = cached_powers_e[index];
+
+    return power;
+}
+
+static size_t count_decimal_digits(const uint32_t n)
+{
+    size_t digits = 1;
+
+    while ((digits < 10) && (n >= powers_of_ten_32[digits]))
+    {
+        digits++;
+    }
+
+    return digits;
+}
+
+/* move the last digit closer to the exact value while staying inside the rounding interval */
+static void grisu_round(unsigned char * const digits, const size_t length, const uint64_t delta, uint64_t rest, const uint64_t ten_kappa, const uint64_t distance)
+{
+    while ((rest < distance) && ((delta - rest) >= ten_kappa) && (((rest + ten_kappa) < distance) || ((distance - rest) > (rest + ten_kappa - distance))))
+    {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static size_t grisu_generate_digits(const diy_fp w, const diy_fp upper, uint64_t delta, unsigned char * const digits, int * const decimal_exponent)
+{
+    const int shift = -upper.e;
+    const uint64_t one = UINT64_C(1) << shift;
+    const uint64_t distance = upper.f - w.f;
+    uint32_t integral = (uint32_t)(upper.f >> shift);
+    uint64_t fractional = upper.f & (one - 1);
+    size_t kappa = count_decimal_digits(integral);
+    size_t length = 0;
+
+    while (kappa > 0)
+    {
+        uint32_t digit = integral / powers_of_ten_32[kappa - 1];
+        uint64_t rest = 0;
+
+        integral %= powers_of_ten_32[kappa - 1];
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        kappa--;
+
+        rest = ((uint64_t)integral << shift) + fractional;
+        if (rest <= delta)
+        {
+            *decimal_exponent += (int)kappa;
+            grisu_round(digits, length, delta, rest, (uint64_t)powers_of_ten_32[kappa] << shift, distance);
+            return length;
+        }
+    }
+
+    /* kappa counts the digits after the decimal point from here on, as a negative number */
+    for (;;)
+    {
+        unsigned char digit = 0;
+
+        fractional *= 10;
+        delta *= 10;
+        digit = (unsigned char)(fractional >> shift);
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        fractional &= one - 1;
+        kappa++;
+
+        if (fractional < delta)
+        {
+            *decimal_exponent -= (int)kappa;
+            grisu_round(digits, length, delta, fractional, one, (kappa < 10) ? (distance * powers_of_ten_32[kappa]) : 0);
+            return length;
+        }
+    }
+}
+
+/* digits receives up to 17 decimal digits, the value is digits * 10^decimal_exponent. value has to be finite and > 0 */
+static size_t grisu2(const double value, unsigned char * const digits, int * const decimal_exponent)
+{
+    const diy_fp v = diy_fp_from_double(value);
+    diy_fp lower;
+    diy_fp upper;
+    diy_fp power;
+    diy_fp w;
+    int k = 0;
+
+    diy_fp_boundaries(v, &lower, &upper);
+    power = cached_power(upper.e, &k);
+
+    w = diy_fp_multiply(diy_fp_normalize(v), power);
+    upper = diy_fp_multiply(upper, power);
+    lower = diy_fp_multiply(lower, power);
+    /* stay strictly inside the rounding interval, the products may be off by one */
+    upper.f--;
+    lower.f++;
+
+    *decimal_exponent = k;
+    return grisu_generate_digits(w, upper, upper.f - lower.f, digits, decimal_exponent);
+}
+
+/* write the decimal representation of value, returns the number of characters */
+static size_t print_uint64(uint64_t value, unsigned char * const output)
+{
+    unsigned char reversed[20];
+    size_t length = 0;
     size_t i = 0;
-    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test = 0.0;
 
-    if (output_buffer == NULL)
+    do
     {
-        return false;
+        reversed[length++] = (unsigned char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    for (i = 0; i < length; i++)
+    {
+        output[i] = reversed[length - 1 - i];
     }
 
+    return length;
+}
+
+/* Lay out digits * 10^decimal_exponent like JavaScript does: plain decimal notation for magnitudes in
+ * [1e-6, 1e21), exponential notation outside of that. Returns the number of characters written. */
+static size_t format_shortest(const unsigned char * const digits, const size_t length, const int decimal_exponent, unsigned char * const output)
+{
+    /* position of the decimal point relative to the first digit */
+    const int point = (int)length + decimal_exponent;
+    size_t written = 0;
+    int i = 0;
+
+    if ((decimal_exponent >= 0) && (point <= 21))
+    {
+        /* integer: 1234e2 -> 123400 */
+        memcpy(output, digits, length);
+        written = length;
+        for (i = 0; i < decimal_exponent; i++)
+        {
+            output[written++] = '0';
+        }
+    }
+    else if ((point > 0) && (point <= 21))
+    {
+        /* 1234e-2 -> 12.34 */
+        memcpy(output, digits, (size_t)point);
+        output[point] = '.';
+        memcpy(output + point + 1, digits + point, length - (size_t)point);
+        written = length + 1;
+    }
+    else if ((point <= 0) && (point > -6))
+    {
+        /* 1234e-6 -> 0.001234 */
+        output[written++] = '0';
+        output[written++] = '.';
+        for (i = point; i < 0; i++)
+        {
+            output[written++] = '0';
+        }
+        memcpy(output + written, digits, length);
+        written += length;
+    }
+    else
+    {
+        /* 1234e30 -> 1.234e+33 */
+        int exponent = point - 1;
+
+        output[written++] = digits[0];
+        if (length > 1)
+        {
+            output[written++] = '.';
+            memcpy(output + written, digits + 1, length - 1);
+            written += length - 1;
+        }
+        output[written++] = 'e';
+        if (exponent < 0)
+        {
+            output[written++] = '-';
+            exponent = -exponent;
+        }
+        else
+        {
+            output[written++] = '+';
+        }
+        written += print_uint64((uint64_t)exponent, output + written);
+    }
+
+    return written;
+}
+
+/* Print d rounded to a fixed number of decimals. Returns 0 if the scaled value does not fit into the mantissa,
+ * the caller falls back to the shortest representation then. */
+static size_t format_fixed(const double d, const int decimals, unsigned char * const output)
+{
+    const double scaled = floor((fabs(d) * exact_powers_of_ten[decimals]) + 0.5);
+    uint64_t integral = 0;
+    uint64_t fraction = 0;
+    uint64_t divisor = 1;
+    size_t written = 0;
+    int i = 0;
+
+    if (!(scaled < (double)MAX_EXACT_INTEGER))
+    {
+        return 0;
+    }
+
+    for (i = 0; i < decimals; i++)
+    {
+        divisor *= 10;
+    }
+    integral = (uint64_t)scaled / divisor;
+    fraction = (uint64_t)scaled % divisor;
+
+    /* don't print -0.00 for small negative values */
+    if ((d < 0) && (scaled != 0))
+    {
+        output[written++] = '-';
+    }
+    written += print_uint64(integral, output + written);
+    if (decimals > 0)
+    {
+        output[written++] = '.';
+        for (i = decimals - 1; i >= 0; i--)
+        {
+            output[written + (size_t)i] = (unsigned char)('0' + (fraction % 10));
+            fraction /= 10;
+        }
+        written += (size_t)decimals;
+    }
+
+    return written;
+}
+
+/* Render the number nicely from the given item into a string. */
+/* Render the number of item into number_buffer (at least 32 bytes, not terminated), returns the length. */
+static size_t render_number(const cJSON * const item, unsigned char * const number_buffer)
+{
+    double d = item->valuedouble;
+    int precision = (item->type & cJSON_PrecisionMask) >> cJSON_PrecisionShift;
+    size_t length = 0;
+    unsigned char digits[32];
+    size_t digit_count = 0;
+    int decimal_exponent = 0;
+
     /* This checks for NaN and Infinity */
     if (isnan(d) || isinf(d))
     {
-        length = sprintf((char*)number_buffer, "null");
+        memcpy(number_buffer, "null", 4);
+        length = 4;
+    }
+    else if ((precision != 0) && ((length = format_fixed(d, precision - 1, number_buffer)) != 0))
+    {
+        /* fixed number of decimals, see cJSON_SetNumberPrecision */
+    }
+    else if (d == (double)item->valueint)
+    {
+        if (item->valueint < 0)
+        {
+            number_buffer[length++] = '-';
+        }
+        length += print_uint64((item->valueint < 0) ? (uint64_t)(-(int64_t)item->valueint) : (uint64_t)item->valueint, number_buffer + length);
+    }
+    else if (d == 0)
+    {
+        /* grisu2 needs a value > 0, this is only reached when valueint was written directly */
+        number_buffer[length++] = '0';
     }
-	else if(d == (double)item->valueint)
-	{
-		length = sprintf((char*)number_buffer, "%d", item->valueint);
-	}
     else
     {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char*)number_buffer, "%1.15g", d);
-
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || !compare_double((double)test, d))
+        if (d < 0)
         {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char*)number_buffer, "%1.17g", d);
+            number_buffer[length++] = '-';
+            d = -d;
         }
+        digit_count = grisu2(d, digits, &decimal_exponent);
+        length += format_shortest(digits, digit_count, decimal_exponent, number_buffer + length);
     }
 
-    /* sprintf failed or buffer overrun occurred */
-    if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1)))
+    return length;
+}
+
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    size_t length = 0;
+    unsigned char number_buffer[32] = {0}; /* temporary buffer to print the number into */
+
+    if (output_buffer == NULL)
     {
         return false;
     }
 
+    length = render_number(item, number_buffer);
+
     /* reserve appropriate space in the output */
-    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
+    output_pointer = ensure(output_buffer, length + sizeof(""));
     if (output_pointer == NULL)
     {
         return false;
     }
 
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
+    memcpy(output_pointer, number_buffer, length);
+    output_pointer[length] = '\0';
+
+    output_buffer->offset += length;
+
+    return true;
+}
+
+/* Word at a time (SWAR) scanning helpers: a size_t is used as a vector of bytes,
+ * 4 bytes per step on the ESP32, 8 on 64 bit hosts. All tests are exact for "any byte in the word". */
+typedef size_t scan_word;
+#define scan_ones (((scan_word)-1) / 0xFF)
+#define scan_highs (scan_ones * 0x80)
+/* non zero if any byte of x is zero */
+#define scan_has_zero(x) (((x) - scan_ones) & ~(x) & scan_highs)
+/* non zero if any byte of x equals c */
+#define scan_has_byte(x, c) scan_has_zero((x) ^ (scan_ones * (c)))
+/* non zero if any byte of x is less than n (n <= 128) */
+#define scan_has_less(x, n) (((x) - (scan_ones * (n))) & ~(x) & scan_highs)
+/* non zero if any byte of x is greater than n (n < 128) */
+#define scan_has_more(x, n) ((((x) + (scan_ones * (127 - (n)))) | (x)) & scan_highs)
+
+#ifdef CJSON_SCAN_WORDS
+/* Bytes looked at one at a time before the word loops start. Shorter runs are done by a small loop that stays
+ * inlined in the parser and printer, only longer ones call out to the word (and SSE2) loops below. */
+#define CJSON_SCAN_PREFIX 16
+#if defined(__GNUC__)
+#define CJSON_SCAN_OUT_OF_LINE __attribute__((noinline))
+#else
+#define CJSON_SCAN_OUT_OF_LINE
+#endif
+
+static scan_word load_scan_word(const unsigned char * const pointer)
+{
+    scan_word word;
+    memcpy(&word, pointer, sizeof(word)); /* unaligned safe, compiles to a plain load where possible */
+    return word;
+}
+
+static const unsigned char *scan_prefix_end(const unsigned char * const pointer, const unsigned char * const end)
+{
+    return ((size_t)(end - pointer) > CJSON_SCAN_PREFIX) ? (pointer + CJSON_SCAN_PREFIX) : end;
+}
+
+/* find_quote_or_backslash past the prefix */
+static CJSON_SCAN_OUT_OF_LINE const unsigned char *find_quote_or_backslash_long(const unsigned char *pointer, const unsigned char * const end)
+{
+#ifdef CJSON_SCAN_SSE2
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while ((end - pointer) >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)pointer);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0)
+        {
+            return pointer + __builtin_ctz((unsigned int)mask);
+        }
+        pointer += 16;
+    }
+#endif
+    while ((size_t)(end - pointer) >= sizeof(scan_word))
     {
-        if (number_buffer[i] == decimal_point)
+        scan_word word = load_scan_word(pointer);
+        if (scan_has_byte(word, '\"') || scan_has_byte(word, '\\'))
         {
-            output_pointer[i] = '.';
-            continue;
+            break;
+        }
+        pointer += sizeof(scan_word);
+    }
+    while ((pointer < end) && (*pointer != '\"') && (*pointer != '\\'))
+    {
+        pointer++;
+    }
+
+    return pointer;
+}
+
+/* find_escape past the prefix */
+static CJSON_SCAN_OUT_OF_LINE const unsigned char *find_escape_long(const unsigned char *pointer, const unsigned char * const end)
+{
+    while ((size_t)(end - pointer) >= sizeof(scan_word))
+    {
+        scan_word word = load_scan_word(pointer);
+        if (scan_has_less(word, 32) || scan_has_byte(word, '\"') || scan_has_byte(word, '\\'))
+        {
+            break;
         }
+        pointer += sizeof(scan_word);
+    }
+    while ((pointer < end) && (*pointer >= 32) && (*pointer != '\"') && (*pointer != '\\'))
+    {
+        pointer++;
+    }
+
+    return pointer;
+}
+#endif
 
-        output_pointer[i] = number_buffer[i];
+/* first '\"' or '\\' in [pointer, end), end if there is none */
+static const unsigned char *find_quote_or_backslash(const unsigned char *pointer, const unsigned char * const end)
+{
+#ifdef CJSON_SCAN_WORDS
+    const unsigned char * const prefix_end = scan_prefix_end(pointer, end);
+    while ((pointer < prefix_end) && (*pointer != '\"') && (*pointer != '\\'))
+    {
+        pointer++;
     }
-    output_pointer[i] = '\0';
 
-    output_buffer->offset += (size_t)length;
+    return ((pointer < end) && (pointer == prefix_end)) ? find_quote_or_backslash_long(pointer, end) : pointer;
+#else
+    while ((pointer < end) && (*pointer != '\"') && (*pointer != '\\'))
+    {
+        pointer++;
+    }
 
-    return true;
+    return pointer;
+#endif
+}
+
+/* first byte in [pointer, end) that has to be escaped when printing ('\"', '\\' or a control character), end if there is none */
+static const unsigned char *find_escape(const unsigned char *pointer, const unsigned char * const end)
+{
+#ifdef CJSON_SCAN_WORDS
+    const unsigned char * const prefix_end = scan_prefix_end(pointer, end);
+    while ((pointer < prefix_end) && (*pointer >= 32) && (*pointer != '\"') && (*pointer != '\\'))
+    {
+        pointer++;
+    }
+
+    return ((pointer < end) && (pointer == prefix_end)) ? find_escape_long(pointer, end) : pointer;
+#else
+    while ((pointer < end) && (*pointer >= 32) && (*pointer != '\"') && (*pointer != '\\'))
+    {
+        pointer++;
+    }
+
+    return pointer;
+#endif
 }
 
 /* parse 4 digit hexadecimal number */
@@ -795,42 +1620,80 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
         /* calculate approximate size of the output (overestimate) */
         size_t allocation_length = 0;
         size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+        const unsigned char * const content_end = input_buffer->content + input_buffer->length;
+        for (;;)
         {
+            /* jump straight to the next quote or escape sequence */
+            input_end = find_quote_or_backslash(input_end, content_end);
+            if (input_end >= content_end)
+            {
+                goto fail; /* string ended unexpectedly */
+            }
+            if (*input_end == '\"')
+            {
+                break;
+            }
+
             /* is escape sequence */
-            if (input_end[0] == '\\')
+            if ((input_end + 1) >= content_end)
             {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
-                {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    goto fail;
-                }
-                skipped_bytes++;
-                input_end++;
+                /* prevent buffer overflow when last input character is a backslash */
+                goto fail;
+            }
+            skipped_bytes++;
+            input_end += 2;
+        }
+
+        if (input_buffer->in_situ)
+        {
+            /* unescaping never makes a string longer, so the output can overwrite the input as it goes */
+            output = (unsigned char*)cast_away_const(input_pointer);
+            if (skipped_bytes == 0)
+            {
+                output_pointer = output + (input_end - input_pointer);
+                input_pointer = input_end;
+                goto done;
             }
-            input_end++;
+            goto unescape;
         }
-        if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
+
+        if (skipped_bytes == 0)
         {
-            goto fail; /* string ended unexpectedly */
+            /* nothing to unescape: a single copy is all it takes */
+            allocation_length = (size_t)(input_end - input_pointer);
+            output = parse_allocate_string(input_buffer, allocation_length + sizeof(""));
+            if (output == NULL)
+            {
+                goto fail; /* allocation failure */
+            }
+            memcpy(output, input_pointer, allocation_length);
+            output_pointer = output + allocation_length;
+            input_pointer = input_end;
+            goto done;
         }
 
         /* This is at most how much we need for the output */
         allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+        output = parse_allocate_string(input_buffer, allocation_length + sizeof(""));
         if (output == NULL)
         {
             goto fail; /* allocation failure */
         }
     }
 
+unescape:
     output_pointer = output;
     /* loop through the string literal */
     while (input_pointer < input_end)
     {
         if (*input_pointer != '\\')
         {
-            *output_pointer++ = *input_pointer++;
+            /* copy the run up to the next escape sequence at once (quotes inside are always escaped),
+             * input and output overlap when parsing in situ */
+            const unsigned char *run_end = find_quote_or_backslash(input_pointer, input_end);
+            memmove(output_pointer, input_pointer, (size_t)(run_end - input_pointer));
+            output_pointer += run_end - input_pointer;
+            input_pointer = run_end;
         }
         /* escape sequence */
         else
@@ -881,10 +1744,12 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
         }
     }
 
+done:
     /* zero terminate the output */
     *output_pointer = '\0';
 
-    item->type = cJSON_String;
+    /* in situ strings point into the input, flag them so cJSON_Delete doesn't free them */
+    item->type = input_buffer->in_situ ? (cJSON_String | cJSON_IsReference) : cJSON_String;
     item->valuestring = (char*)output;
 
     input_buffer->offset = (size_t) (input_end - input_buffer->content);
@@ -893,9 +1758,9 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     return true;
 
 fail:
-    if (output != NULL)
+    if ((output != NULL) && !input_buffer->in_situ)
     {
-        input_buffer->hooks.deallocate(output);
+        parse_deallocate_string(input_buffer, output);
         output = NULL;
     }
 
@@ -907,36 +1772,92 @@ fail:
     return false;
 }
 
-/* Render the cstring provided to an escaped version that can be printed. */
-static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+/* Render a string that is longer than the scratch buffer of a sink backed printbuffer,
+ * one (possibly escaped) character at a time so the sink can be flushed in between. */
+static cJSON_bool print_string_ptr_to_sink(const unsigned char * const input, printbuffer * const output_buffer)
 {
     const unsigned char *input_pointer = NULL;
-    unsigned char *output = NULL;
     unsigned char *output_pointer = NULL;
-    size_t output_length = 0;
-    /* numbers of additional characters needed for escaping */
-    size_t escape_characters = 0;
 
-    if (output_buffer == NULL)
+    output_pointer = ensure(output_buffer, 1);
+    if (output_pointer == NULL)
     {
         return false;
     }
+    *output_pointer = '\"';
+    output_buffer->offset++;
 
-    /* empty string */
-    if (input == NULL)
+    for (input_pointer = input; *input_pointer != '\0'; input_pointer++)
     {
-        output = ensure(output_buffer, sizeof("\"\""));
-        if (output == NULL)
+        size_t length = 1;
+
+        output_pointer = ensure(output_buffer, sizeof("\\u0000"));
+        if (output_pointer == NULL)
         {
             return false;
         }
-        strcpy((char*)output, "\"\"");
 
-        return true;
+        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
+        {
+            *output_pointer = *input_pointer;
+        }
+        else
+        {
+            length = 2;
+            output_pointer[0] = '\\';
+            switch (*input_pointer)
+            {
+                case '\\':
+                    output_pointer[1] = '\\';
+                    break;
+                case '\"':
+                    output_pointer[1] = '\"';
+                    break;
+                case '\b':
+                    output_pointer[1] = 'b';
+                    break;
+                case '\f':
+                    output_pointer[1] = 'f';
+                    break;
+                case '\n':
+                    output_pointer[1] = 'n';
+                    break;
+                case '\r':
+                    output_pointer[1] = 'r';
+                    break;
+                case '\t':
+                    output_pointer[1] = 't';
+                    break;
+                default:
+                    sprintf((char*)output_pointer + 1, "u%04x", *input_pointer);
+                    length = 6;
+                    break;
+            }
+        }
+        output_buffer->offset += length;
+    }
+
+    output_pointer = ensure(output_buffer, 2);
+    if (output_pointer == NULL)
+    {
+        return false;
     }
+    output_pointer[0] = '\"';
+    output_pointer[1] = '\0';
+    output_buffer->offset++;
+
+    return true;
+}
 
-    /* set "flag" to 1 if something needs to be escaped */
-    for (input_pointer = input; *input_pointer; input_pointer++)
+/* Render the cstring provided to an escaped version that can be printed. */
+/* Length of input once escaped, without the quotes. escape_characters receives the number of additional characters. */
+static size_t escaped_string_length(const unsigned char * const input, size_t * const escape_characters)
+{
+    const unsigned char *input_pointer = NULL;
+    const unsigned char *input_end = input + strlen((const char*)input);
+
+    *escape_characters = 0;
+    for (input_pointer = find_escape(input, input_end); input_pointer < input_end; input_pointer = find_escape(input_pointer + 1, input_end))
     {
         switch (*input_pointer)
         {
@@ -948,18 +1869,55 @@ static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffe
             case '\r':
             case '\t':
                 /* one character escape sequence */
-                escape_characters++;
+                (*escape_characters)++;
                 break;
             default:
                 if (*input_pointer < 32)
                 {
                     /* UTF-16 escape sequence uXXXX */
-                    escape_characters += 5;
+                    *escape_characters += 5;
                 }
                 break;
         }
     }
-    output_length = (size_t)(input_pointer - input) + escape_characters;
+
+    return (size_t)(input_end - input) + *escape_characters;
+}
+
+static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+{
+    const unsigned char *input_pointer = NULL;
+    unsigned char *output = NULL;
+    unsigned char *output_pointer = NULL;
+    size_t output_length = 0;
+    /* numbers of additional characters needed for escaping */
+    size_t escape_characters = 0;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* empty string */
+    if (input == NULL)
+    {
+        output = ensure(output_buffer, sizeof("\"\""));
+        if (output == NULL)
+        {
+            return false;
+        }
+        strcpy((char*)output, "\"\"");
+
+        return true;
+    }
+
+    output_length = escaped_string_length(input, &escape_characters);
+
+    if ((output_buffer->sink != NULL) && ((output_length + sizeof("\"\"")) >= output_buffer->length))
+    {
+        /* would never fit into the scratch buffer */
+        return print_string_ptr_to_sink(input, output_buffer);
+    }
 
     output = ensure(output_buffer, output_length + sizeof("\"\""));
     if (output == NULL)
@@ -1034,18 +1992,37 @@ static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
 {
     return print_string_ptr((unsigned char*)item->valuestring, p);
 }
-
-/* Predeclare these prototypes. */
-static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+
+/* Predeclare these prototypes. */
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+
+#ifdef CJSON_SCAN_WORDS
+/* buffer_skip_whitespace past the prefix: whole words of whitespace, for long indentation runs */
+static CJSON_SCAN_OUT_OF_LINE void skip_whitespace_long(parse_buffer * const buffer)
+{
+    while (((buffer->length - buffer->offset) >= sizeof(scan_word)) && !scan_has_more(load_scan_word(buffer_at_offset(buffer)), 32))
+    {
+        buffer->offset += sizeof(scan_word);
+    }
+    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+    {
+       buffer->offset++;
+    }
+}
+#endif
 
 /* Utility to jump whitespace and cr/lf */
 static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
 {
+#ifdef CJSON_SCAN_WORDS
+    size_t prefix_end = 0;
+#endif
+
     if ((buffer == NULL) || (buffer->content == NULL))
     {
         return NULL;
@@ -1056,10 +2033,23 @@ static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
         return buffer;
     }
 
+#ifdef CJSON_SCAN_WORDS
+    /* usually there is no whitespace at all, or a short run */
+    prefix_end = ((buffer->length - buffer->offset) > CJSON_SCAN_PREFIX) ? (buffer->offset + CJSON_SCAN_PREFIX) : buffer->length;
+    while ((buffer->offset < prefix_end) && (buffer_at_offset(buffer)[0] <= 32))
+    {
+        buffer->offset++;
+    }
+    if (buffer->offset == prefix_end)
+    {
+        skip_whitespace_long(buffer);
+    }
+#else
     while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
     {
        buffer->offset++;
     }
+#endif
 
     if (buffer->offset == buffer->length)
     {
@@ -1100,11 +2090,13 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
     return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
 }
 
-/* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+/* Parse an object - create a new root, and populate. Allocates from arena if it is not NULL,
+ * unescapes strings inside value if in_situ is set. */
+static cJSON *parse_root(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_Arena * const arena, const cJSON_bool in_situ)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, NULL, false };
     cJSON *item = NULL;
+    size_t arena_mark = (arena != NULL) ? arena->used : 0;
 
     /* reset error position */
     global_error.json = NULL;
@@ -1119,8 +2111,10 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     buffer.length = buffer_length;
     buffer.offset = 0;
     buffer.hooks = global_hooks;
+    buffer.arena = arena;
+    buffer.in_situ = in_situ;
 
-    item = cJSON_New_Item(&global_hooks);
+    item = parse_new_item(&buffer);
     if (item == NULL) /* memory fail */
     {
         goto fail;
@@ -1151,7 +2145,13 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
 fail:
     if (item != NULL)
     {
-        cJSON_Delete(item);
+        parse_delete_items(&buffer, item);
+    }
+
+    if (arena != NULL)
+    {
+        /* give back whatever the failed parse carved out */
+        arena->used = arena_mark;
     }
 
     if (value != NULL)
@@ -1180,6 +2180,56 @@ fail:
     return NULL;
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_root(value, buffer_length, return_parse_end, require_null_terminated, NULL, false);
+}
+
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    arena->buffer = (unsigned char*)buffer;
+    arena->size = (buffer != NULL) ? size : 0;
+    arena->used = 0;
+}
+
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena)
+{
+    if (arena != NULL)
+    {
+        arena->used = 0;
+    }
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArena(const char *value, size_t buffer_length, cJSON_Arena *arena)
+{
+    if ((arena == NULL) || (arena->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    return parse_root(value, buffer_length, NULL, false, arena, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *buffer, size_t buffer_length)
+{
+    return parse_root(buffer, buffer_length, NULL, false, NULL, true);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituWithArena(char *buffer, size_t buffer_length, cJSON_Arena *arena)
+{
+    if ((arena == NULL) || (arena->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    return parse_root(buffer, buffer_length, NULL, false, arena, true);
+}
+
 /* Default options for cJSON_Parse */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
 {
@@ -1191,73 +2241,139 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
     return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
 }
 
-#define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
-
-static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
+/* Length of the text print_value would produce for item, computed without rendering anything.
+ * Mirrors print_value, print_array and print_object, depth is the printbuffer depth item is printed at. */
+static cJSON_bool measure_value(const cJSON * const item, const cJSON_bool format, const size_t depth, size_t * const length)
 {
-    static const size_t default_buffer_size = 256;
-    printbuffer buffer[1];
-    unsigned char *printed = NULL;
-
-    memset(buffer, 0, sizeof(buffer));
+    unsigned char number_buffer[32];
+    size_t escape_characters = 0;
+    size_t members = 0;
+    const cJSON *current_item = NULL;
 
-    /* create buffer */
-    buffer->buffer = (unsigned char*) hooks->allocate(default_buffer_size);
-    buffer->length = default_buffer_size;
-    buffer->format = format;
-    buffer->hooks = *hooks;
-    if (buffer->buffer == NULL)
+    if (item == NULL)
     {
-        goto fail;
+        return false;
     }
 
-    /* print the value */
-    if (!print_value(item, buffer))
+    switch ((item->type) & 0xFF)
     {
-        goto fail;
+        case cJSON_NULL:
+        case cJSON_True:
+            *length += 4;
+            return true;
+
+        case cJSON_False:
+            *length += 5;
+            return true;
+
+        case cJSON_Number:
+            *length += render_number(item, number_buffer);
+            return true;
+
+        case cJSON_Raw:
+            if (item->valuestring == NULL)
+            {
+                return false;
+            }
+            *length += strlen(item->valuestring);
+            return true;
+
+        case cJSON_String:
+            *length += sizeof("\"\"") - sizeof("");
+            if (item->valuestring != NULL)
+            {
+                *length += escaped_string_length((const unsigned char*)item->valuestring, &escape_characters);
+            }
+            return true;
+
+        case cJSON_Array:
+            /* [a,b] or [a, b] */
+            *length += 2;
+            for (current_item = item->child; current_item != NULL; current_item = current_item->next)
+            {
+                if (!measure_value(current_item, format, depth + 1, length))
+                {
+                    return false;
+                }
+                if (current_item->next != NULL)
+                {
+                    *length += format ? 2 : 1;
+                }
+            }
+            return true;
+
+        case cJSON_Object:
+            /* {"a":b,"c":d} or {\n<tabs>"a":\tb,\n<tabs>"c":\td\n<tabs>} */
+            *length += format ? (2 + depth + 1) : 2;
+            for (current_item = item->child; current_item != NULL; current_item = current_item->next)
+            {
+                members++;
+                *length += sizeof("\"\"") - sizeof("");
+                if (current_item->string != NULL)
+                {
+                    *length += escaped_string_length((const unsigned char*)current_item->string, &escape_characters);
+                }
+                if (!measure_value(current_item, format, depth + 1, length))
+                {
+                    return false;
+                }
+                if (current_item->next != NULL)
+                {
+                    *length += 1;
+                }
+            }
+            /* per member: the tabs, the colon, the tab after it and the newline */
+            *length += format ? (members * (depth + 1 + 3)) : members;
+            return true;
+
+        default:
+            return false;
     }
-    update_offset(buffer);
+}
 
-    /* check if reallocate is available */
-    if (hooks->reallocate != NULL)
+CJSON_PUBLIC(size_t) cJSON_PrintLength(const cJSON *item, cJSON_bool format)
+{
+    size_t length = 0;
+
+    if (!measure_value(item, format, 0, &length) || (length > INT_MAX))
     {
-        printed = (unsigned char*) hooks->reallocate(buffer->buffer, buffer->offset + 1);
-        if (printed == NULL) {
-            goto fail;
-        }
-        buffer->buffer = NULL;
+        return 0;
     }
-    else /* otherwise copy the JSON over to a new buffer */
-    {
-        printed = (unsigned char*) hooks->allocate(buffer->offset + 1);
-        if (printed == NULL)
-        {
-            goto fail;
-        }
-        memcpy(printed, buffer->buffer, cjson_min(buffer->length, buffer->offset + 1));
-        printed[buffer->offset] = '\0'; /* just to be sure */
 
-        /* free the buffer */
-        hooks->deallocate(buffer->buffer);
-        buffer->buffer = NULL;
-    }
+    return length;
+}
+
+static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
+{
+    printbuffer buffer[1];
+    size_t length = 0;
 
-    return printed;
+    memset(buffer, 0, sizeof(buffer));
 
-fail:
-    if (buffer->buffer != NULL)
+    /* measure first, so the text is rendered into a buffer of the final size without any reallocation */
+    length = cJSON_PrintLength(item, format);
+    if (length == 0)
     {
-        hooks->deallocate(buffer->buffer);
-        buffer->buffer = NULL;
+        return NULL;
     }
 
-    if (printed != NULL)
+    buffer->buffer = (unsigned char*) hooks->allocate(length + sizeof(""));
+    buffer->length = length + sizeof("");
+    buffer->noalloc = true;
+    buffer->format = format;
+    buffer->hooks = *hooks;
+    if (buffer->buffer == NULL)
     {
-        hooks->deallocate(printed);
-        printed = NULL;
+        return NULL;
     }
 
-    return NULL;
+    if (!print_value(item, buffer))
+    {
+        hooks->deallocate(buffer->buffer);
+        return NULL;
+    }
+
+    return buffer->buffer;
 }
 
 /* Render a cJSON item/entity/structure to text. */
@@ -1273,7 +2389,7 @@ CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
 
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 }, NULL, NULL };
 
     if (prebuffer < 0)
     {
@@ -1304,7 +2420,7 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
 
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 }, NULL, NULL };
 
     if ((length < 0) || (buffer == NULL))
     {
@@ -1321,6 +2437,33 @@ CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, cons
     return print_value(item, &p);
 }
 
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSink(const cJSON *item, char *buffer, const size_t length, const cJSON_bool format, cJSON_PrintSink sink, void *user_data)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 }, NULL, NULL };
+
+    if ((item == NULL) || (buffer == NULL) || (sink == NULL) || (length < CJSON_PRINT_SINK_MIN_BUFFER))
+    {
+        return false;
+    }
+
+    p.buffer = (unsigned char*)buffer;
+    p.length = length;
+    p.offset = 0;
+    p.noalloc = true;
+    p.format = format;
+    p.hooks = global_hooks;
+    p.sink = sink;
+    p.sink_user_data = user_data;
+
+    if (!print_value(item, &p))
+    {
+        return false;
+    }
+    update_offset(&p);
+
+    return flush_printbuffer(&p);
+}
+
 /* Parser core - when encountering text, process appropriately. */
 static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -1489,7 +2632,7 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
     do
     {
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        cJSON *new_item = parse_new_item(input_buffer);
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1542,7 +2685,7 @@ success:
 fail:
     if (head != NULL)
     {
-        cJSON_Delete(head);
+        parse_delete_items(input_buffer, head);
     }
 
     return false;
@@ -1647,7 +2790,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
     do
     {
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        cJSON *new_item = parse_new_item(input_buffer);
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1684,6 +2827,10 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         /* swap valuestring and string, because we parsed the name */
         current_item->string = current_item->valuestring;
         current_item->valuestring = NULL;
+        if (input_buffer->in_situ)
+        {
+            current_item->type |= cJSON_StringIsConst;
+        }
 
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
@@ -1697,6 +2844,11 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         {
             goto fail; /* failed to parse value */
         }
+        if (input_buffer->in_situ)
+        {
+            /* parse_value replaced the type */
+            current_item->type |= cJSON_StringIsConst;
+        }
         buffer_skip_whitespace(input_buffer);
     }
     while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
@@ -1722,7 +2874,7 @@ success:
 fail:
     if (head != NULL)
     {
-        cJSON_Delete(head);
+        parse_delete_items(input_buffer, head);
     }
 
     return false;
@@ -1895,15 +3047,162 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
     return get_array_item(array, (size_t)index);
 }
 
+/* Hash index of the members of an object, see cJSON_EnableObjectIndex.
+ * Objects don't use valuestring, so an indexed object keeps its table there and cJSON_Delete frees it along with
+ * the object. The table is built on the first lookup and dropped whenever a member is added, removed or replaced.
+ * Open addressing with linear probing: the members are inserted in list order, so for duplicate keys the probe
+ * finds the same (first) member the linear search would. */
+typedef struct
+{
+    uint32_t hash;
+    cJSON *item;
+} object_index_slot;
+
+typedef struct
+{
+    size_t mask; /* number of slots - 1, the number of slots is a power of two */
+} object_index;
+
+#define object_index_slots(index) ((object_index_slot*)((index) + 1))
+
+/* FNV-1a over the lower case key, so that both case sensitive and insensitive lookups can use the same index */
+static uint32_t object_key_hash(const unsigned char *key)
+{
+    uint32_t hash = UINT32_C(2166136261);
+
+    for (; *key != '\0'; key++)
+    {
+        hash ^= (uint32_t)tolower(*key);
+        hash *= UINT32_C(16777619);
+    }
+
+    return hash;
+}
+
+static object_index *build_object_index(cJSON * const object)
+{
+    object_index *index = NULL;
+    object_index_slot *slots = NULL;
+    cJSON *child = NULL;
+    size_t members = 0;
+    size_t capacity = 8;
+
+    for (child = object->child; child != NULL; child = child->next)
+    {
+        members++;
+    }
+
+    /* walking a short list is cheaper than hashing */
+    if (members < CJSON_OBJECT_INDEX_MIN_MEMBERS)
+    {
+        return NULL;
+    }
+
+    /* keep the load factor at or below 1/2 */
+    while (capacity < (members * 2))
+    {
+        capacity <<= 1;
+    }
+
+    index = (object_index*)global_hooks.allocate(sizeof(object_index) + (capacity * sizeof(object_index_slot)));
+    if (index == NULL)
+    {
+        return NULL;
+    }
+    index->mask = capacity - 1;
+    slots = object_index_slots(index);
+    memset(slots, '\0', capacity * sizeof(object_index_slot));
+
+    for (child = object->child; child != NULL; child = child->next)
+    {
+        uint32_t hash = 0;
+        size_t position = 0;
+
+        if (child->string == NULL)
+        {
+            continue;
+        }
+
+        hash = object_key_hash((const unsigned char*)child->string);
+        for (position = hash & index->mask; slots[position].item != NULL; position = (position + 1) & index->mask)
+        {
+        }
+        slots[position].hash = hash;
+        slots[position].item = child;
+    }
+
+    object->valuestring = (char*)index;
+
+    return index;
+}
+
+/* called by everything that changes the members of an object */
+static void invalidate_object_index(cJSON * const object)
+{
+    if ((object != NULL) && (object->type & cJSON_IndexedObject) && (object->valuestring != NULL))
+    {
+        global_hooks.deallocate(object->valuestring);
+        object->valuestring = NULL;
+    }
+}
+
+static cJSON *find_in_object_index(const object_index * const index, const char * const name, const cJSON_bool case_sensitive)
+{
+    const object_index_slot *slots = object_index_slots(index);
+    uint32_t hash = object_key_hash((const unsigned char*)name);
+    size_t position = 0;
+
+    for (position = hash & index->mask; slots[position].item != NULL; position = (position + 1) & index->mask)
+    {
+        if (slots[position].hash != hash)
+        {
+            continue;
+        }
+        if (case_sensitive ? (strcmp(name, slots[position].item->string) == 0) : (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)slots[position].item->string) == 0))
+        {
+            return slots[position].item;
+        }
+    }
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_EnableObjectIndex(cJSON *object)
+{
+    if (!cJSON_IsObject(object) || (object->type & cJSON_IsReference))
+    {
+        return false;
+    }
+
+    object->type |= cJSON_IndexedObject;
+
+    return true;
+}
+
 static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
 {
     cJSON *current_element = NULL;
+    object_index *index = NULL;
 
     if ((object == NULL) || (name == NULL))
     {
         return NULL;
     }
 
+    if (object->type & cJSON_IndexedObject)
+    {
+        index = (object_index*)object->valuestring;
+        if (index == NULL)
+        {
+            /* building the index doesn't change the object as far as the caller can tell */
+            index = build_object_index((cJSON*)cast_away_const(object));
+        }
+        if (index != NULL)
+        {
+            return find_in_object_index(index, name, case_sensitive);
+        }
+    }
+
     current_element = object->child;
     if (case_sensitive)
     {
@@ -1967,6 +3266,12 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
     memcpy(reference, item, sizeof(cJSON));
     reference->string = NULL;
     reference->type |= cJSON_IsReference;
+    if (reference->type & cJSON_IndexedObject)
+    {
+        /* the index belongs to item */
+        reference->type &= ~cJSON_IndexedObject;
+        reference->valuestring = NULL;
+    }
     reference->next = reference->prev = NULL;
     return reference;
 }
@@ -1980,6 +3285,8 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
         return false;
     }
 
+    invalidate_object_index(array);
+
     child = array->child;
     /*
      * To find the last item in array quickly, we use prev in array
@@ -2209,6 +3516,8 @@ CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const it
         return NULL;
     }
 
+    invalidate_object_index(parent);
+
     if (item != parent->child)
     {
         /* not the first element */
@@ -2298,6 +3607,8 @@ CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON
         return false;
     }
 
+    invalidate_object_index(array);
+
     newitem->next = after_inserted;
     newitem->prev = after_inserted->prev;
     after_inserted->prev = newitem;
@@ -2324,6 +3635,8 @@ CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON
         return true;
     }
 
+    invalidate_object_index(parent);
+
     replacement->next = item->next;
     replacement->prev = item->prev;
 
@@ -2748,7 +4061,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     newitem->type = item->type & (~cJSON_IsReference);
     newitem->valueint = item->valueint;
     newitem->valuedouble = item->valuedouble;
-    if (item->valuestring)
+    if (item->valuestring && !(item->type & cJSON_IndexedObject))
     {
         newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, &global_hooks);
         if (!newitem->valuestring)
@@ -2758,7 +4071,9 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     }
     if (item->string)
     {
-        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        /* keys are always copied: a cJSON_StringIsConst key may point into an in situ buffer the copy must not depend on */
+        newitem->type &= ~cJSON_StringIsConst;
+        newitem->string = (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
         if (!newitem->string)
         {
             goto fail;
@@ -98,6 +98,10 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+#define cJSON_IndexedObject 1024 /* see cJSON_EnableObjectIndex */
+/* number of decimals + 1 for numbers printed with a fixed precision, see cJSON_SetNumberPrecision */
+#define cJSON_PrecisionShift 12
+#define cJSON_PrecisionMask (0x1F << cJSON_PrecisionShift)
 
 /* The cJSON structure: */
 typedef struct cJSON
@@ -131,6 +135,21 @@ typedef struct cJSON_Hooks
 
 typedef int cJSON_bool;
 
+/* Caller supplied bump arena for cJSON_ParseWithArena. Nodes and strings are carved out of buffer,
+ * so a parse does not touch the heap at all. Trees parsed into an arena must NOT be passed to cJSON_Delete,
+ * release them all at once with cJSON_ResetArena instead. */
+typedef struct cJSON_Arena
+{
+    unsigned char *buffer;
+    size_t size;
+    size_t used;
+} cJSON_Arena;
+
+/* Alignment of the nodes carved out of an arena. */
+#ifndef CJSON_ARENA_ALIGNMENT
+#define CJSON_ARENA_ALIGNMENT 8
+#endif
+
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_NESTING_LIMIT
@@ -151,6 +170,19 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error so will match cJSON_GetErrorPtr(). */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* Arena backed parsing: every node and string of the result lives inside arena, nothing is malloc'ed.
+ * Returns NULL if the text is invalid or the arena is too small (the arena is left as it was in that case).
+ * The tree stays valid until the arena is reset; it must not be modified with the Add/Replace/Delete calls. */
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size);
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArena(const char *value, size_t buffer_length, cJSON_Arena *arena);
+
+/* In situ parsing: strings are unescaped inside buffer itself and valuestring/string point into it, so the tree
+ * owns no string memory. buffer is modified (also when the parse fails) and has to outlive the tree.
+ * cJSON_Delete still frees the nodes, the strings are flagged cJSON_IsReference/cJSON_StringIsConst and are left
+ * alone; cJSON_Duplicate gives an independent copy. The arena variant doesn't allocate at all. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *buffer, size_t buffer_length);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituWithArena(char *buffer, size_t buffer_length, cJSON_Arena *arena);
 
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
@@ -159,8 +191,19 @@ CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item);
 /* Render a cJSON entity to text using a buffered strategy. prebuffer is a guess at the final size. guessing well reduces reallocation. fmt=0 gives unformatted, =1 gives formatted */
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt);
 /* Render a cJSON entity to text using a buffer already allocated in memory with given length. Returns 1 on success and 0 on failure. */
-/* NOTE: cJSON is not always 100% accurate in estimating how much memory it will use, so to be safe allocate 5 bytes more than you actually need */
+/* cJSON_PrintLength(item, format) + 1 bytes are always enough. */
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format);
+/* Exact length of the text cJSON_Print (format=1) or cJSON_PrintUnformatted (format=0) produce, without the terminator.
+ * Nothing is rendered or allocated. Returns 0 if the item can't be printed. */
+CJSON_PUBLIC(size_t) cJSON_PrintLength(const cJSON *item, cJSON_bool format);
+/* Render a cJSON entity through a fixed scratch buffer. Whenever the buffer is full its content is handed to sink
+ * (which returns false to abort) and the buffer is reused, so the memory needed does not depend on the size of the output.
+ * Strings of any length are split across flushes, raw items have to fit into the buffer as a whole. Returns 1 on success and 0 on failure. */
+#ifndef CJSON_PRINT_SINK_MIN_BUFFER
+#define CJSON_PRINT_SINK_MIN_BUFFER 64
+#endif
+typedef cJSON_bool (*cJSON_PrintSink)(const char *data, size_t length, void *user_data);
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSink(const cJSON *item, char *buffer, const size_t length, const cJSON_bool format, cJSON_PrintSink sink, void *user_data);
 /* Delete a cJSON entity and all subentities. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item);
 
@@ -172,6 +215,15 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string);
+/* Opt in to a hash index for lookups in object. The index is built on the first cJSON_GetObjectItem and dropped
+ * whenever members are added, removed or replaced through the cJSON API, so repeated lookups are O(1) instead of
+ * walking the list. Worth it for objects with dozens of members or more, smaller ones are still searched linearly.
+ * The index is allocated with the global hooks, don't use it on trees parsed into an arena.
+ * Keys must not be changed behind cJSON's back (writing item->string directly) while the index is enabled. */
+#ifndef CJSON_OBJECT_INDEX_MIN_MEMBERS
+#define CJSON_OBJECT_INDEX_MIN_MEMBERS 8
+#endif
+CJSON_PUBLIC(cJSON_bool) cJSON_EnableObjectIndex(cJSON *object);
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void);
 
@@ -276,6 +328,12 @@ CJSON_PUBLIC(cJSON*) cJSON_AddArrayToObject(cJSON * const object, const char * c
 /* helper for the cJSON_SetNumberValue macro */
 CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number);
 #define cJSON_SetNumberValue(object, number) ((object != NULL) ? cJSON_SetNumberHelper(object, (double)number) : (number))
+/* Print a number with a fixed number of decimals (0..CJSON_MAX_PRECISION) instead of the shortest representation
+ * that parses back to the same double, e.g. 2 for float sensor readings: 21.3f prints as 21.30 instead of
+ * 21.299999237060547. For an array or object this applies to all of its direct number children.
+ * A negative value restores the default. */
+#define CJSON_MAX_PRECISION 15
+CJSON_PUBLIC(cJSON_bool) cJSON_SetNumberPrecision(cJSON *item, int decimals);
 /* Change the valuestring of a cJSON_String object, only takes effect when type of object is cJSON_String */
 CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring);
 
@@ -0,0 +1,985 @@
+/* cJSON_Bind */
+/* Typed struct binding, see cJSON_Bind.h */
+
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "cJSON_Bind.h"
+#include "cJSON_Sax.h"
+
+/* define our own boolean type */
+#ifdef true
+#undef true
+#endif
+#define true ((cJSON_bool)1)
+
+#ifdef false
+#undef false
+#endif
+#define false ((cJSON_bool)0)
+
+/* define isnan and isinf for ANSI C, if in C99 or above, isnan and isinf has been defined in math.h */
+#ifndef isinf
+#define isinf(d) (isnan((d - d)) && !isnan(d))
+#endif
+#ifndef isnan
+#define isnan(d) (d != d)
+#endif
+
+typedef struct
+{
+    const cJSON_BindField *fields;
+    size_t field_count;
+    unsigned char *base;
+    uint32_t seen; /* bit per field */
+} bind_frame;
+
+typedef struct
+{
+    bind_frame frames[CJSON_BIND_NESTING_LIMIT];
+    size_t depth;                   /* number of open bound objects */
+    const cJSON_BindField *current; /* field the next value belongs to, NULL if its key is unknown */
+    size_t skip_depth;              /* > 0 while inside a container that is being skipped */
+    cJSON_bool in_array;
+    size_t array_index;
+    cJSON_bool started;
+    cJSON_BindStatus status;
+    const char *error_field;
+} bind_decoder;
+
+static cJSON_bool decode_fail(bind_decoder * const decoder, cJSON_BindStatus status)
+{
+    decoder->status = status;
+    decoder->error_field = (decoder->current != NULL) ? decoder->current->name : NULL;
+
+    return false;
+}
+
+static cJSON_bool descriptor_valid(const cJSON_BindField * const fields, const size_t field_count)
+{
+    size_t i = 0;
+
+    if ((fields == NULL) || (field_count == 0) || (field_count > CJSON_BIND_MAX_FIELDS))
+    {
+        return false;
+    }
+
+    for (i = 0; i < field_count; i++)
+    {
+        if ((fields[i].name == NULL) || (fields[i].size == 0))
+        {
+            return false;
+        }
+        if ((fields[i].count > 0) && (fields[i].type > cJSON_BindDouble))
+        {
+            return false; /* only arrays of bools and numbers */
+        }
+        if ((fields[i].type == cJSON_BindObject) && !descriptor_valid(fields[i].fields, fields[i].field_count))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* where the value for the current field goes */
+static unsigned char *current_target(const bind_decoder * const decoder)
+{
+    const bind_frame *frame = &decoder->frames[decoder->depth - 1];
+    unsigned char *target = frame->base + decoder->current->offset;
+
+    if (decoder->in_array)
+    {
+        target += decoder->array_index * decoder->current->size;
+    }
+
+    return target;
+}
+
+static void mark_seen(bind_decoder * const decoder)
+{
+    bind_frame *frame = &decoder->frames[decoder->depth - 1];
+
+    frame->seen |= (uint32_t)1 << (size_t)(decoder->current - frame->fields);
+}
+
+/* a scalar has been stored, the next one needs a new key unless we are inside an array */
+static void value_stored(bind_decoder * const decoder)
+{
+    if (decoder->in_array)
+    {
+        decoder->array_index++;
+    }
+    else
+    {
+        decoder->current = NULL;
+    }
+}
+
+/* values without a descriptor are skipped, returns true if the value has to be bound */
+static cJSON_bool wants_value(bind_decoder * const decoder)
+{
+    if ((decoder->skip_depth > 0) || (decoder->current == NULL))
+    {
+        return false;
+    }
+
+    if (decoder->in_array && (decoder->array_index >= decoder->current->count))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+static cJSON_bool check_array_space(bind_decoder * const decoder)
+{
+    if ((decoder->skip_depth == 0) && (decoder->current != NULL) && decoder->in_array && (decoder->array_index >= decoder->current->count))
+    {
+        return decode_fail(decoder, cJSON_BindArrayTooLong);
+    }
+
+    return true;
+}
+
+static cJSON_bool store_integer(unsigned char * const target, const size_t size, const cJSON_bool is_signed, const double number)
+{
+    if (is_signed)
+    {
+        int8_t value8 = 0;
+        int16_t value16 = 0;
+        int32_t value32 = 0;
+        int64_t value64 = 0;
+
+        switch (size)
+        {
+            case 1:
+                if ((number < INT8_MIN) || (number > INT8_MAX))
+                {
+                    return false;
+                }
+                value8 = (int8_t)number;
+                memcpy(target, &value8, size);
+                return true;
+            case 2:
+                if ((number < INT16_MIN) || (number > INT16_MAX))
+                {
+                    return false;
+                }
+                value16 = (int16_t)number;
+                memcpy(target, &value16, size);
+                return true;
+            case 4:
+                if ((number < INT32_MIN) || (number > INT32_MAX))
+                {
+                    return false;
+                }
+                value32 = (int32_t)number;
+                memcpy(target, &value32, size);
+                return true;
+            case 8:
+                if ((number < -CJSON_BIND_INTEGER_LIMIT) || (number > CJSON_BIND_INTEGER_LIMIT))
+                {
+                    return false;
+                }
+                value64 = (int64_t)number;
+                memcpy(target, &value64, size);
+                return true;
+            default:
+                return false;
+        }
+    }
+    else
+    {
+        uint8_t value8 = 0;
+        uint16_t value16 = 0;
+        uint32_t value32 = 0;
+        uint64_t value64 = 0;
+
+        if (number < 0)
+        {
+            return false;
+        }
+
+        switch (size)
+        {
+            case 1:
+                if (number > UINT8_MAX)
+                {
+                    return false;
+                }
+                value8 = (uint8_t)number;
+                memcpy(target, &value8, size);
+                return true;
+            case 2:
+                if (number > UINT16_MAX)
+                {
+                    return false;
+                }
+                value16 = (uint16_t)number;
+                memcpy(target, &value16, size);
+                return true;
+            case 4:
+                if (number > UINT32_MAX)
+                {
+                    return false;
+                }
+                value32 = (uint32_t)number;
+                memcpy(target, &value32, size);
+                return true;
+            case 8:
+                if (number > CJSON_BIND_INTEGER_LIMIT)
+                {
+                    return false;
+                }
+                value64 = (uint64_t)number;
+                memcpy(target, &value64, size);
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+static cJSON_bool on_number(double number, void *user_data)
+{
+    bind_decoder *decoder = (bind_decoder*)user_data;
+    const cJSON_BindField *field = decoder->current;
+    unsigned char *target = NULL;
+
+    if (!check_array_space(decoder))
+    {
+        return false;
+    }
+    if (!wants_value(decoder))
+    {
+        return true;
+    }
+
+    target = current_target(decoder);
+    if ((field->minimum < field->maximum) && ((number < field->minimum) || (number > field->maximum)))
+    {
+        return decode_fail(decoder, cJSON_BindOutOfRange);
+    }
+
+    switch (field->type)
+    {
+        case cJSON_BindInt:
+        case cJSON_BindUInt:
+            if ((number != floor(number)) || !store_integer(target, field->size, field->type == cJSON_BindInt, number))
+            {
+                return decode_fail(decoder, cJSON_BindOutOfRange);
+            }
+            break;
+
+        case cJSON_BindFloat:
+        {
+            float value = (float)number;
+            if (field->size != sizeof(float))
+            {
+                return decode_fail(decoder, cJSON_BindInvalidDescriptor);
+            }
+            if (isinf(value))
+            {
+                /* would be encoded as null */
+                return decode_fail(decoder, cJSON_BindOutOfRange);
+            }
+            memcpy(target, &value, sizeof(value));
+            break;
+        }
+
+        case cJSON_BindDouble:
+            if (field->size != sizeof(double))
+            {
+                return decode_fail(decoder, cJSON_BindInvalidDescriptor);
+            }
+            memcpy(target, &number, sizeof(number));
+            break;
+
+        default:
+            return decode_fail(decoder, cJSON_BindTypeMismatch);
+    }
+
+    mark_seen(decoder);
+    value_stored(decoder);
+
+    return true;
+}
+
+static cJSON_bool on_boolean(cJSON_bool value, void *user_data)
+{
+    bind_decoder *decoder = (bind_decoder*)user_data;
+    const cJSON_BindField *field = decoder->current;
+    unsigned char *target = NULL;
+
+    if (!check_array_space(decoder))
+    {
+        return false;
+    }
+    if (!wants_value(decoder))
+    {
+        return true;
+    }
+
+    if (field->type != cJSON_BindBool)
+    {
+        return decode_fail(decoder, cJSON_BindTypeMismatch);
+    }
+
+    /* bool as well as wider integer flags */
+    target = current_target(decoder);
+    if (!store_integer(target, field->size, false, value ? 1 : 0))
+    {
+        return decode_fail(decoder, cJSON_BindInvalidDescriptor);
+    }
+
+    mark_seen(decoder);
+    value_stored(decoder);
+
+    return true;
+}
+
+static cJSON_bool on_string(const char *value, size_t length, void *user_data)
+{
+    bind_decoder *decoder = (bind_decoder*)user_data;
+    const cJSON_BindField *field = decoder->current;
+
+    if (!check_array_space(decoder))
+    {
+        return false;
+    }
+    if (!wants_value(decoder))
+    {
+        return true;
+    }
+
+    if ((field->type != cJSON_BindString) || decoder->in_array)
+    {
+        return decode_fail(decoder, cJSON_BindTypeMismatch);
+    }
+    if (length >= field->size)
+    {
+        return decode_fail(decoder, cJSON_BindStringTooLong);
+    }
+
+    memcpy(current_target(decoder), value, length + 1);
+
+    mark_seen(decoder);
+    value_stored(decoder);
+
+    return true;
+}
+
+static cJSON_bool on_null(void *user_data)
+{
+    bind_decoder *decoder = (bind_decoder*)user_data;
+
+    if (!check_array_space(decoder))
+    {
+        return false;
+    }
+
+    /* null leaves the member as it was and counts as absent */
+    if (wants_value(decoder))
+    {
+        value_stored(decoder);
+    }
+
+    return true;
+}
+
+static cJSON_bool on_key(const char *key, size_t length, void *user_data)
+{
+    bind_decoder *decoder = (bind_decoder*)user_data;
+    const bind_frame *frame = NULL;
+    size_t i = 0;
+
+    (void)length;
+
+    if (decoder->skip_depth > 0)
+    {
+        return true;
+    }
+
+    frame = &decoder->frames[decoder->depth - 1];
+    decoder->current = NULL;
+    for (i = 0; i < frame->field_count; i++)
+    {
+        if (strcmp(frame->fields[i].name, key) == 0)
+        {
+            decoder->current = &frame->fields[i];
+            break;
+        }
+    }
+
+    return true;
+}
+
+static cJSON_bool on_start_object(void *user_data)
+{
+    bind_decoder *decoder = (bind_decoder*)user_data;
+    const cJSON_BindField *field = decoder->current;
+    bind_frame *frame = NULL;
+
+    if (!decoder->started)
+    {
+        /* the root frame has been set up by cJSON_BindDecode */
+        decoder->started = true;
+        return true;
+    }
+
+    if (!check_array_space(decoder))
+    {
+        return false;
+    }
+    if (!wants_value(decoder))
+    {
+        decoder->skip_depth++;
+        return true;
+    }
+
+    if ((field->type != cJSON_BindObject) || decoder->in_array)
+    {
+        return decode_fail(decoder, cJSON_BindTypeMismatch);
+    }
+    if (decoder->depth >= CJSON_BIND_NESTING_LIMIT)
+    {
+        return decode_fail(decoder, cJSON_BindTooDeep);
+    }
+
+    mark_seen(decoder);
+    frame = &decoder->frames[decoder->depth];
+    frame->fields = field->fields;
+    frame->field_count = field->field_count;
+    frame->base = decoder->frames[decoder->depth - 1].base + field->offset;
+    frame->seen = 0;
+    decoder->depth++;
+    decoder->current = NULL;
+
+    return true;
+}
+
+static cJSON_bool on_end_object(void *user_data)
+{
+    bind_decoder *decoder = (bind_decoder*)user_data;
+    const bind_frame *frame = NULL;
+    size_t i = 0;
+
+    if (decoder->skip_depth > 0)
+    {
+        decoder->skip_depth--;
+        return true;
+    }
+
+    frame = &decoder->frames[decoder->depth - 1];
+    for (i = 0; i < frame->field_count; i++)
+    {
+        if ((frame->fields[i].flags & cJSON_BindRequired) && !(frame->seen & ((uint32_t)1 << i)))
+        {
+            decoder->current = &frame->fields[i];
+            return decode_fail(decoder, cJSON_BindMissingField);
+        }
+    }
+
+    decoder->depth--;
+    decoder->current = NULL;
+
+    return true;
+}
+
+static cJSON_bool on_start_array(void *user_data)
+{
+    bind_decoder *decoder = (bind_decoder*)user_data;
+
+    if (!decoder->started)
+    {
+        decoder->status = cJSON_BindNotAnObject;
+        return false;
+    }
+
+    if (!check_array_space(decoder))
+    {
+        return false;
+    }
+    if (!wants_value(decoder))
+    {
+        decoder->skip_depth++;
+        return true;
+    }
+
+    if ((decoder->current->count == 0) || decoder->in_array)
+    {
+        return decode_fail(decoder, cJSON_BindTypeMismatch);
+    }
+
+    mark_seen(decoder);
+    decoder->in_array = true;
+    decoder->array_index = 0;
+
+    return true;
+}
+
+static cJSON_bool on_end_array(void *user_data)
+{
+    bind_decoder *decoder = (bind_decoder*)user_data;
+
+    if (decoder->skip_depth > 0)
+    {
+        decoder->skip_depth--;
+        return true;
+    }
+
+    decoder->in_array = false;
+    decoder->current = NULL;
+
+    return true;
+}
+
+static const cJSON_SaxCallbacks bind_callbacks =
+{
+    on_start_object,
+    on_end_object,
+    on_start_array,
+    on_end_array,
+    on_key,
+    on_string,
+    on_number,
+    on_boolean,
+    on_null
+};
+
+static void decoder_init(bind_decoder * const decoder, const cJSON_BindField * const fields, const size_t field_count, void * const object)
+{
+    memset(decoder, '\0', sizeof(bind_decoder));
+    decoder->frames[0].fields = fields;
+    decoder->frames[0].field_count = field_count;
+    decoder->frames[0].base = (unsigned char*)object;
+    decoder->depth = 1;
+    decoder->status = cJSON_BindOk;
+}
+
+CJSON_PUBLIC(cJSON_BindStatus) cJSON_BindDecode(const cJSON_BindField *fields, size_t field_count, void *object, const char *json, size_t length, const char **error_field)
+{
+    bind_decoder decoder;
+    cJSON_SaxParser parser;
+    char token[CJSON_BIND_TOKEN_SIZE];
+    cJSON_SaxStatus status = cJSON_SaxOk;
+
+    if (error_field != NULL)
+    {
+        *error_field = NULL;
+    }
+
+    if ((object == NULL) || (json == NULL) || !descriptor_valid(fields, field_count))
+    {
+        return cJSON_BindInvalidDescriptor;
+    }
+
+    decoder_init(&decoder, fields, field_count, object);
+
+    cJSON_SaxInit(&parser, &bind_callbacks, &decoder, token, sizeof(token));
+    status = cJSON_SaxFeed(&parser, json, length);
+    if ((status == cJSON_SaxOk) || (status == cJSON_SaxDone))
+    {
+        status = cJSON_SaxFinish(&parser);
+    }
+
+    switch (status)
+    {
+        case cJSON_SaxDone:
+            if (!decoder.started)
+            {
+                decoder.status = cJSON_BindNotAnObject;
+            }
+            break;
+        case cJSON_SaxAborted:
+            /* a callback set decoder.status */
+            break;
+        case cJSON_SaxTokenTooLong:
+            decoder.status = cJSON_BindStringTooLong;
+            decoder.error_field = (decoder.current != NULL) ? decoder.current->name : NULL;
+            break;
+        case cJSON_SaxTooDeep:
+            decoder.status = cJSON_BindTooDeep;
+            break;
+        default:
+            decoder.status = cJSON_BindSyntaxError;
+            break;
+    }
+
+    if ((decoder.status != cJSON_BindOk) && (error_field != NULL))
+    {
+        *error_field = decoder.error_field;
+    }
+
+    return decoder.status;
+}
+
+/* feeds a parsed tree to the decoder as the events the SAX parser would produce for its text */
+static cJSON_bool replay_item(const cJSON * const item, bind_decoder * const decoder, const size_t depth)
+{
+    const cJSON *child = NULL;
+
+    if (depth > CJSON_SAX_NESTING_LIMIT)
+    {
+        decoder->status = cJSON_BindTooDeep;
+        return false;
+    }
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_False:
+            return on_boolean(false, decoder);
+        case cJSON_True:
+            return on_boolean(true, decoder);
+        case cJSON_NULL:
+            return on_null(decoder);
+        case cJSON_Number:
+            return on_number(item->valuedouble, decoder);
+        case cJSON_String:
+            return on_string(item->valuestring, strlen(item->valuestring), decoder);
+        case cJSON_Array:
+            if (!on_start_array(decoder))
+            {
+                return false;
+            }
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                if (!replay_item(child, decoder, depth + 1))
+                {
+                    return false;
+                }
+            }
+            return on_end_array(decoder);
+        case cJSON_Object:
+            if (!on_start_object(decoder))
+            {
+                return false;
+            }
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                if ((child->string == NULL) || !on_key(child->string, strlen(child->string), decoder) || !replay_item(child, decoder, depth + 1))
+                {
+                    return false;
+                }
+            }
+            return on_end_object(decoder);
+        default:
+            /* raw or invalid items have no JSON value the decoder could check */
+            decoder->status = cJSON_BindSyntaxError;
+            return false;
+    }
+}
+
+CJSON_PUBLIC(cJSON_BindStatus) cJSON_BindDecodeItem(const cJSON_BindField *fields, size_t field_count, void *object, const cJSON *item, const char **error_field)
+{
+    bind_decoder decoder;
+
+    if (error_field != NULL)
+    {
+        *error_field = NULL;
+    }
+
+    if ((object == NULL) || (item == NULL) || !descriptor_valid(fields, field_count))
+    {
+        return cJSON_BindInvalidDescriptor;
+    }
+    if ((item->type & 0xFF) != cJSON_Object)
+    {
+        return cJSON_BindNotAnObject;
+    }
+
+    decoder_init(&decoder, fields, field_count, object);
+    replay_item(item, &decoder, 1);
+
+    if ((decoder.status != cJSON_BindOk) && (error_field != NULL))
+    {
+        *error_field = decoder.error_field;
+    }
+
+    return decoder.status;
+}
+
+typedef struct
+{
+    char *buffer;
+    size_t size;
+    size_t length;
+} bind_writer;
+
+#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+    #pragma GCC diagnostic push
+#endif
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+/* helper function to cast away const, the strings are only read while printing */
+static void* cast_away_const(const void* string)
+{
+    return (void*)string;
+}
+#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+    #pragma GCC diagnostic pop
+#endif
+
+static cJSON_bool write_raw(bind_writer * const writer, const char * const text, const size_t length)
+{
+    /* keep room for the terminator */
+    if ((writer->length + length) >= writer->size)
+    {
+        return false;
+    }
+
+    memcpy(writer->buffer + writer->length, text, length);
+    writer->length += length;
+    writer->buffer[writer->length] = '\0';
+
+    return true;
+}
+
+/* let cJSON render a single string or number straight into the output, so escaping and number formatting are the
+ * same as cJSON_Print */
+static cJSON_bool write_item(bind_writer * const writer, cJSON * const item)
+{
+    size_t available = writer->size - writer->length;
+
+    if (available > INT32_MAX)
+    {
+        available = INT32_MAX;
+    }
+    if (!cJSON_PrintPreallocated(item, writer->buffer + writer->length, (int)available, false))
+    {
+        return false;
+    }
+    writer->length += strlen(writer->buffer + writer->length);
+
+    return true;
+}
+
+static double load_number(const cJSON_BindField * const field, const unsigned char * const source)
+{
+    int8_t i8 = 0;
+    int16_t i16 = 0;
+    int32_t i32 = 0;
+    int64_t i64 = 0;
+    uint8_t u8 = 0;
+    uint16_t u16 = 0;
+    uint32_t u32 = 0;
+    uint64_t u64 = 0;
+    float f = 0;
+    double d = 0;
+
+    switch (field->type)
+    {
+        case cJSON_BindFloat:
+            memcpy(&f, source, sizeof(f));
+            return (double)f;
+        case cJSON_BindDouble:
+            memcpy(&d, source, sizeof(d));
+            return d;
+        case cJSON_BindInt:
+            switch (field->size)
+            {
+                case 1:
+                    memcpy(&i8, source, 1);
+                    return (double)i8;
+                case 2:
+                    memcpy(&i16, source, 2);
+                    return (double)i16;
+                case 4:
+                    memcpy(&i32, source, 4);
+                    return (double)i32;
+                default:
+                    memcpy(&i64, source, 8);
+                    return (double)i64;
+            }
+        default:
+            switch (field->size)
+            {
+                case 1:
+                    memcpy(&u8, source, 1);
+                    return (double)u8;
+                case 2:
+                    memcpy(&u16, source, 2);
+                    return (double)u16;
+                case 4:
+                    memcpy(&u32, source, 4);
+                    return (double)u32;
+                default:
+                    memcpy(&u64, source, 8);
+                    return (double)u64;
+            }
+    }
+}
+
+/* 8 byte integers beyond CJSON_BIND_INTEGER_LIMIT would not read back as the same value, checked on the integer
+ * itself since the conversion to double already rounds */
+static cJSON_bool integer_fits_double(const cJSON_BindField * const field, const unsigned char * const source)
+{
+    int64_t i64 = 0;
+    uint64_t u64 = 0;
+
+    if (((field->type != cJSON_BindInt) && (field->type != cJSON_BindUInt)) || (field->size != 8))
+    {
+        return true;
+    }
+    if (field->type == cJSON_BindInt)
+    {
+        memcpy(&i64, source, sizeof(i64));
+        return (i64 >= -((int64_t)1 << 53)) && (i64 <= ((int64_t)1 << 53));
+    }
+    memcpy(&u64, source, sizeof(u64));
+
+    return u64 <= ((uint64_t)1 << 53);
+}
+
+static cJSON_BindStatus encode_scalar(bind_writer * const writer, const cJSON_BindField * const field, const unsigned char * const source)
+{
+    cJSON item;
+    size_t i = 0;
+    cJSON_bool written = false;
+
+    memset(&item, '\0', sizeof(item));
+
+    switch (field->type)
+    {
+        case cJSON_BindBool:
+            for (i = 0; (i < field->size) && (source[i] == 0); i++)
+            {
+            }
+            written = (i < field->size) ? write_raw(writer, "true", 4) : write_raw(writer, "false", 5);
+            break;
+
+        case cJSON_BindString:
+            /* the member may not be terminated if it was filled by hand */
+            if (memchr(source, '\0', field->size) == NULL)
+            {
+                return cJSON_BindStringTooLong;
+            }
+            item.type = cJSON_String | cJSON_IsReference;
+            item.valuestring = (char*)cast_away_const(source);
+            written = write_item(writer, &item);
+            break;
+
+        default:
+            if (!integer_fits_double(field, source))
+            {
+                return cJSON_BindOutOfRange;
+            }
+            item.type = cJSON_Number;
+            cJSON_SetNumberValue(&item, load_number(field, source));
+            if (((field->type == cJSON_BindFloat) || (field->type == cJSON_BindDouble)) && (field->decimals >= 0))
+            {
+                cJSON_SetNumberPrecision(&item, field->decimals);
+            }
+            written = write_item(writer, &item);
+            break;
+    }
+
+    return written ? cJSON_BindOk : cJSON_BindBufferTooSmall;
+}
+
+static cJSON_BindStatus encode_object(bind_writer * const writer, const cJSON_BindField * const fields, const size_t field_count, const unsigned char * const base, const size_t depth)
+{
+    cJSON_BindStatus status = cJSON_BindOk;
+    size_t i = 0;
+    size_t element = 0;
+
+    if (depth > CJSON_BIND_NESTING_LIMIT)
+    {
+        return cJSON_BindTooDeep;
+    }
+
+    if (!write_raw(writer, "{", 1))
+    {
+        return cJSON_BindBufferTooSmall;
+    }
+
+    for (i = 0; i < field_count; i++)
+    {
+        const cJSON_BindField *field = &fields[i];
+        cJSON key;
+
+        memset(&key, '\0', sizeof(key));
+        key.type = cJSON_String | cJSON_IsReference;
+        key.valuestring = (char*)cast_away_const(field->name);
+        if (((i > 0) && !write_raw(writer, ",", 1)) || !write_item(writer, &key) || !write_raw(writer, ":", 1))
+        {
+            return cJSON_BindBufferTooSmall;
+        }
+
+        if (field->type == cJSON_BindObject)
+        {
+            status = encode_object(writer, field->fields, field->field_count, base + field->offset, depth + 1);
+            if (status != cJSON_BindOk)
+            {
+                return status;
+            }
+            continue;
+        }
+
+        if (field->count == 0)
+        {
+            status = encode_scalar(writer, field, base + field->offset);
+            if (status != cJSON_BindOk)
+            {
+                return status;
+            }
+            continue;
+        }
+
+        if (!write_raw(writer, "[", 1))
+        {
+            return cJSON_BindBufferTooSmall;
+        }
+        for (element = 0; element < field->count; element++)
+        {
+            if ((element > 0) && !write_raw(writer, ",", 1))
+            {
+                return cJSON_BindBufferTooSmall;
+            }
+            status = encode_scalar(writer, field, base + field->offset + (element * field->size));
+            if (status != cJSON_BindOk)
+            {
+                return status;
+            }
+        }
+        if (!write_raw(writer, "]", 1))
+        {
+            return cJSON_BindBufferTooSmall;
+        }
+    }
+
+    if (!write_raw(writer, "}", 1))
+    {
+        return cJSON_BindBufferTooSmall;
+    }
+
+    return cJSON_BindOk;
+}
+
+CJSON_PUBLIC(cJSON_BindStatus) cJSON_BindEncode(const cJSON_BindField *fields, size_t field_count, const void *object, char *buffer, size_t size, size_t *length)
+{
+    bind_writer writer;
+    cJSON_BindStatus status = cJSON_BindOk;
+
+    if ((object == NULL) || (buffer == NULL) || (size == 0) || !descriptor_valid(fields, field_count))
+    {
+        return cJSON_BindInvalidDescriptor;
+    }
+
+    writer.buffer = buffer;
+    writer.size = size;
+    writer.length = 0;
+    buffer[0] = '\0';
+
+    status = encode_object(&writer, fields, field_count, (const unsigned char*)object, 1);
+    if (length != NULL)
+    {
+        *length = (status == cJSON_BindOk) ? writer.length : 0;
+    }
+
+    return status;
+}
@@ -0,0 +1,122 @@
+#ifndef cJSON_Bind__h
+#define cJSON_Bind__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include "cJSON.h"
+
+/* Typed struct binding.
+ * A table of field descriptors (JSON name, member offset, type, bounds) maps a JSON object onto a C struct.
+ * cJSON_BindDecode parses text straight into the struct with the push tokenizer from cJSON_Sax.h, no tree is built
+ * and nothing is allocated. cJSON_BindEncode writes the struct back out as JSON text into a caller buffer.
+ * Keys that have no descriptor are skipped, missing or mistyped fields are reported as a status code together
+ * with the name of the offending field. */
+
+/* Maximum nesting of bound objects. */
+#ifndef CJSON_BIND_NESTING_LIMIT
+#define CJSON_BIND_NESTING_LIMIT 8
+#endif
+
+/* Longest string or number token decode accepts, also for keys that are skipped. */
+#ifndef CJSON_BIND_TOKEN_SIZE
+#define CJSON_BIND_TOKEN_SIZE 128
+#endif
+
+/* A descriptor table of one object can have at most this many fields (required fields are tracked in a bit set). */
+#define CJSON_BIND_MAX_FIELDS 32
+
+/* Numbers travel as double, so 8 byte integers only round trip up to 2^53. Larger magnitudes are rejected with
+ * cJSON_BindOutOfRange by decode as well as encode. */
+#define CJSON_BIND_INTEGER_LIMIT 9007199254740992.0
+
+typedef enum
+{
+    cJSON_BindBool = 0,  /* bool / cJSON_bool of any size */
+    cJSON_BindInt,       /* signed integer or enum of 1, 2, 4 or 8 bytes, 8 bytes within +-CJSON_BIND_INTEGER_LIMIT */
+    cJSON_BindUInt,      /* unsigned integer of 1, 2, 4 or 8 bytes, 8 bytes up to CJSON_BIND_INTEGER_LIMIT */
+    cJSON_BindFloat,     /* numbers beyond the float range are out of range, not infinity */
+    cJSON_BindDouble,
+    cJSON_BindString,    /* char array, zero terminated */
+    cJSON_BindObject     /* nested struct, described by fields */
+} cJSON_BindType;
+
+/* field flags */
+#define cJSON_BindRequired 1 /* decode fails with cJSON_BindMissingField if the key is absent or null */
+
+typedef struct cJSON_BindField
+{
+    const char *name;
+    cJSON_BindType type;
+    size_t offset;
+    size_t size;       /* of the member, of one element for arrays */
+    size_t count;      /* 0 for a single value, the number of elements for a fixed size array */
+    int flags;
+    double minimum;    /* numbers: bounds checked on decode if minimum < maximum */
+    double maximum;
+    int decimals;      /* floats: fixed number of decimals on encode, -1 for the shortest round trip */
+    const struct cJSON_BindField *fields; /* cJSON_BindObject */
+    size_t field_count;
+} cJSON_BindField;
+
+typedef enum
+{
+    cJSON_BindOk = 0,
+    cJSON_BindSyntaxError,      /* not valid JSON */
+    cJSON_BindNotAnObject,      /* the top level value is not an object */
+    cJSON_BindMissingField,     /* a required field was absent or null */
+    cJSON_BindTypeMismatch,     /* the JSON type doesn't match the descriptor */
+    cJSON_BindOutOfRange,       /* number outside the bounds or the member type, or not an integer (encode: an 8 byte
+                                 * integer beyond CJSON_BIND_INTEGER_LIMIT) */
+    cJSON_BindStringTooLong,    /* string doesn't fit into the member (or a token into CJSON_BIND_TOKEN_SIZE) */
+    cJSON_BindArrayTooLong,     /* more elements than the member holds */
+    cJSON_BindTooDeep,          /* CJSON_BIND_NESTING_LIMIT exceeded */
+    cJSON_BindBufferTooSmall,   /* encode output doesn't fit */
+    cJSON_BindInvalidDescriptor
+} cJSON_BindStatus;
+
+/* Descriptor helpers, e.g.
+ *     static const cJSON_BindField command_fields[] = {
+ *         CJSON_BIND_INT(command_t, type, "type", cJSON_BindRequired, 0, 20),
+ *         CJSON_BIND_STRING(command_t, key, "key", cJSON_BindRequired),
+ *     }; */
+#define CJSON_BIND_MEMBER_SIZE(type, member) sizeof(((type*)0)->member)
+#define CJSON_BIND_BOOL(type, member, name, flags) \
+    { name, cJSON_BindBool, offsetof(type, member), CJSON_BIND_MEMBER_SIZE(type, member), 0, flags, 0, 0, -1, NULL, 0 }
+#define CJSON_BIND_INT(type, member, name, flags, minimum, maximum) \
+    { name, cJSON_BindInt, offsetof(type, member), CJSON_BIND_MEMBER_SIZE(type, member), 0, flags, minimum, maximum, -1, NULL, 0 }
+#define CJSON_BIND_UINT(type, member, name, flags, minimum, maximum) \
+    { name, cJSON_BindUInt, offsetof(type, member), CJSON_BIND_MEMBER_SIZE(type, member), 0, flags, minimum, maximum, -1, NULL, 0 }
+#define CJSON_BIND_FLOAT(type, member, name, flags, minimum, maximum, decimals) \
+    { name, cJSON_BindFloat, offsetof(type, member), CJSON_BIND_MEMBER_SIZE(type, member), 0, flags, minimum, maximum, decimals, NULL, 0 }
+#define CJSON_BIND_DOUBLE(type, member, name, flags, minimum, maximum, decimals) \
+    { name, cJSON_BindDouble, offsetof(type, member), CJSON_BIND_MEMBER_SIZE(type, member), 0, flags, minimum, maximum, decimals, NULL, 0 }
+#define CJSON_BIND_STRING(type, member, name, flags) \
+    { name, cJSON_BindString, offsetof(type, member), CJSON_BIND_MEMBER_SIZE(type, member), 0, flags, 0, 0, -1, NULL, 0 }
+#define CJSON_BIND_OBJECT(type, member, name, flags, sub_fields) \
+    { name, cJSON_BindObject, offsetof(type, member), CJSON_BIND_MEMBER_SIZE(type, member), 0, flags, 0, 0, -1, sub_fields, sizeof(sub_fields) / sizeof((sub_fields)[0]) }
+/* fixed size array of bools or numbers, element_type is one of cJSON_BindBool .. cJSON_BindDouble */
+#define CJSON_BIND_ARRAY(type, member, name, element_type, flags, decimals) \
+    { name, element_type, offsetof(type, member), CJSON_BIND_MEMBER_SIZE(type, member[0]), \
+      CJSON_BIND_MEMBER_SIZE(type, member) / CJSON_BIND_MEMBER_SIZE(type, member[0]), flags, 0, 0, decimals, NULL, 0 }
+
+/* Decode the JSON object in json (length bytes, no terminator needed) into object.
+ * Members without a matching key are left untouched, so object should be initialized with defaults.
+ * Array members are filled from the start, elements past the end of the JSON array are left untouched as well.
+ * On failure error_field (if not NULL) is set to the name of the field that caused it, or NULL. */
+CJSON_PUBLIC(cJSON_BindStatus) cJSON_BindDecode(const cJSON_BindField *fields, size_t field_count, void *object, const char *json, size_t length, const char **error_field);
+/* Same as cJSON_BindDecode for an already parsed item, e.g. an element of an array or a cJSON_ParseCbor result */
+CJSON_PUBLIC(cJSON_BindStatus) cJSON_BindDecodeItem(const cJSON_BindField *fields, size_t field_count, void *object, const cJSON *item, const char **error_field);
+/* Encode object as an unformatted JSON object into buffer, zero terminated. length (if not NULL) receives the
+ * length of the text without the terminator. */
+CJSON_PUBLIC(cJSON_BindStatus) cJSON_BindEncode(const cJSON_BindField *fields, size_t field_count, const void *object, char *buffer, size_t size, size_t *length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,569 @@
+/* cJSON_Cbor */
+/* CBOR encoding of cJSON trees, see cJSON_Cbor.h */
+
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "cJSON_Cbor.h"
+
+/* define our own boolean type */
+#ifdef true
+#undef true
+#endif
+#define true ((cJSON_bool)1)
+
+#ifdef false
+#undef false
+#endif
+#define false ((cJSON_bool)0)
+
+/* define isnan and isinf for ANSI C, if in C99 or above, isnan and isinf has been defined in math.h */
+#ifndef isinf
+#define isinf(d) (isnan((d - d)) && !isnan(d))
+#endif
+#ifndef isnan
+#define isnan(d) (d != d)
+#endif
+
+#ifndef NAN
+#define NAN (0.0/0.0)
+#endif
+#ifndef INFINITY
+#define INFINITY (1.0/0.0)
+#endif
+
+/* major types */
+#define CBOR_UNSIGNED 0
+#define CBOR_NEGATIVE 1
+#define CBOR_BYTES 2
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_TAG 6
+#define CBOR_SIMPLE 7
+
+/* additional information of major type 7 */
+#define CBOR_FALSE 20
+#define CBOR_TRUE 21
+#define CBOR_NULL 22
+#define CBOR_UNDEFINED 23
+#define CBOR_HALF 25
+#define CBOR_SINGLE 26
+#define CBOR_DOUBLE 27
+#define CBOR_INDEFINITE 31
+#define CBOR_BREAK 0xFF
+
+static const double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+typedef struct
+{
+    unsigned char *buffer; /* NULL to only count the bytes */
+    size_t size;
+    size_t offset;
+} cbor_writer;
+
+typedef struct
+{
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+} cbor_reader;
+
+static cJSON_bool write_bytes(cbor_writer * const writer, const unsigned char *bytes, const size_t length)
+{
+    if (writer->buffer != NULL)
+    {
+        if (length > (writer->size - writer->offset))
+        {
+            return false;
+        }
+        if (length > 0)
+        {
+            memcpy(writer->buffer + writer->offset, bytes, length);
+        }
+    }
+    writer->offset += length;
+
+    return true;
+}
+
+/* initial byte plus a big endian argument of 0, 1, 2, 4 or 8 bytes */
+static cJSON_bool write_head(cbor_writer * const writer, const unsigned char major, uint64_t value)
+{
+    unsigned char head[9];
+    size_t length = 0;
+    size_t i = 0;
+
+    if (value < 24)
+    {
+        head[0] = (unsigned char)((major << 5) | value);
+        length = 1;
+    }
+    else if (value <= 0xFF)
+    {
+        head[0] = (unsigned char)((major << 5) | 24);
+        length = 2;
+    }
+    else if (value <= 0xFFFF)
+    {
+        head[0] = (unsigned char)((major << 5) | 25);
+        length = 3;
+    }
+    else if (value <= 0xFFFFFFFF)
+    {
+        head[0] = (unsigned char)((major << 5) | 26);
+        length = 5;
+    }
+    else
+    {
+        head[0] = (unsigned char)((major << 5) | 27);
+        length = 9;
+    }
+
+    for (i = length - 1; i > 0; i--)
+    {
+        head[i] = (unsigned char)(value & 0xFF);
+        value >>= 8;
+    }
+
+    return write_bytes(writer, head, length);
+}
+
+/* head with the raw bits of a float, additional is CBOR_HALF, CBOR_SINGLE or CBOR_DOUBLE */
+static cJSON_bool write_float_bits(cbor_writer * const writer, const unsigned char additional, uint64_t bits)
+{
+    unsigned char head[9];
+    size_t length = (additional == CBOR_HALF) ? 3 : ((additional == CBOR_SINGLE) ? 5 : 9);
+    size_t i = 0;
+
+    head[0] = (unsigned char)((CBOR_SIMPLE << 5) | additional);
+    for (i = length - 1; i > 0; i--)
+    {
+        head[i] = (unsigned char)(bits & 0xFF);
+        bits >>= 8;
+    }
+
+    return write_bytes(writer, head, length);
+}
+
+static cJSON_bool write_string(cbor_writer * const writer, const char * const string)
+{
+    size_t length = (string != NULL) ? strlen(string) : 0;
+
+    return write_head(writer, CBOR_TEXT, length) && write_bytes(writer, (const unsigned char*)string, length);
+}
+
+/* Nearest half precision float of a normal (or zero) value, false if it is out of range or subnormal. */
+static cJSON_bool double_to_half(const double value, uint16_t * const half)
+{
+    uint16_t sign = (value < 0) ? 0x8000 : 0;
+    double mantissa = 0;
+    int exponent = 0;
+    unsigned int fraction = 0;
+
+    if (value == 0)
+    {
+        *half = sign;
+        return true;
+    }
+
+    /* value = mantissa * 2^exponent with 0.5 <= mantissa < 1, so the half exponent is exponent - 1 */
+    mantissa = frexp(fabs(value), &exponent);
+    exponent--;
+    fraction = (unsigned int)floor((mantissa * 2 - 1) * 1024 + 0.5);
+    if (fraction == 1024)
+    {
+        fraction = 0;
+        exponent++;
+    }
+    if ((exponent < -14) || (exponent > 15))
+    {
+        return false;
+    }
+
+    *half = (uint16_t)(sign | ((unsigned int)(exponent + 15) << 10) | fraction);
+
+    return true;
+}
+
+static double half_to_double(const uint16_t half)
+{
+    int exponent = (half >> 10) & 0x1F;
+    unsigned int fraction = half & 0x3FF;
+    double value = 0;
+
+    if (exponent == 0)
+    {
+        value = ldexp((double)fraction, -24);
+    }
+    else if (exponent == 31)
+    {
+        value = (fraction == 0) ? INFINITY : NAN;
+    }
+    else
+    {
+        value = ldexp((double)(fraction + 1024), exponent - 25);
+    }
+
+    return (half & 0x8000) ? -value : value;
+}
+
+static cJSON_bool write_number(cbor_writer * const writer, const cJSON * const item)
+{
+    double d = item->valuedouble;
+    int precision = (item->type & cJSON_PrecisionMask) >> cJSON_PrecisionShift;
+    double scale = 1;
+    double target = 0;
+    uint16_t half = 0;
+    float single = 0;
+    uint32_t single_bits = 0;
+    uint64_t double_bits = 0;
+
+    if (isnan(d))
+    {
+        return write_float_bits(writer, CBOR_HALF, 0x7E00);
+    }
+    if (isinf(d))
+    {
+        return write_float_bits(writer, CBOR_HALF, (d < 0) ? 0xFC00 : 0x7C00);
+    }
+
+    if ((precision != 0) && ((precision - 1) < (int)(sizeof(powers_of_ten) / sizeof(powers_of_ten[0]))))
+    {
+        /* only the digits that would be printed have to survive */
+        scale = powers_of_ten[precision - 1];
+        target = floor(d * scale + 0.5);
+        d = target / scale;
+    }
+    else
+    {
+        precision = 0;
+    }
+
+    if ((d == floor(d)) && (d >= -9223372036854775808.0) && (d < 18446744073709551616.0))
+    {
+        if (d < 0)
+        {
+            return write_head(writer, CBOR_NEGATIVE, (uint64_t)(-1 - (int64_t)d));
+        }
+        return write_head(writer, CBOR_UNSIGNED, (uint64_t)d);
+    }
+
+    if (double_to_half(d, &half) && ((precision != 0) ? (floor(half_to_double(half) * scale + 0.5) == target) : (half_to_double(half) == d)))
+    {
+        return write_float_bits(writer, CBOR_HALF, half);
+    }
+
+    single = (float)d;
+    if ((precision != 0) ? (floor((double)single * scale + 0.5) == target) : ((double)single == d))
+    {
+        memcpy(&single_bits, &single, sizeof(single_bits));
+        return write_float_bits(writer, CBOR_SINGLE, single_bits);
+    }
+
+    memcpy(&double_bits, &d, sizeof(double_bits));
+    return write_float_bits(writer, CBOR_DOUBLE, double_bits);
+}
+
+static cJSON_bool write_value(cbor_writer * const writer, const cJSON * const item, const size_t depth)
+{
+    const cJSON *child = NULL;
+    size_t count = 0;
+
+    if ((item == NULL) || (depth >= CJSON_NESTING_LIMIT))
+    {
+        return false;
+    }
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_False:
+            return write_head(writer, CBOR_SIMPLE, CBOR_FALSE);
+
+        case cJSON_True:
+            return write_head(writer, CBOR_SIMPLE, CBOR_TRUE);
+
+        case cJSON_NULL:
+            return write_head(writer, CBOR_SIMPLE, CBOR_NULL);
+
+        case cJSON_Number:
+            return write_number(writer, item);
+
+        case cJSON_String:
+            return write_string(writer, item->valuestring);
+
+        case cJSON_Array:
+        case cJSON_Object:
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                count++;
+            }
+            if (!write_head(writer, ((item->type & 0xFF) == cJSON_Array) ? CBOR_ARRAY : CBOR_MAP, count))
+            {
+                return false;
+            }
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                if ((((item->type & 0xFF) == cJSON_Object) && !write_string(writer, child->string)) || !write_value(writer, child, depth + 1))
+                {
+                    return false;
+                }
+            }
+            return true;
+
+        default:
+            /* cJSON_Raw is JSON text, there is nothing to encode it as */
+            return false;
+    }
+}
+
+CJSON_PUBLIC(size_t) cJSON_CborLength(const cJSON *item)
+{
+    cbor_writer writer = { NULL, 0, 0 };
+
+    if (!write_value(&writer, item, 0))
+    {
+        return 0;
+    }
+
+    return writer.offset;
+}
+
+CJSON_PUBLIC(size_t) cJSON_PrintCbor(const cJSON *item, unsigned char *buffer, size_t size)
+{
+    cbor_writer writer = { NULL, 0, 0 };
+
+    if (buffer == NULL)
+    {
+        return 0;
+    }
+
+    writer.buffer = buffer;
+    writer.size = size;
+    if (!write_value(&writer, item, 0))
+    {
+        return 0;
+    }
+
+    return writer.offset;
+}
+
+static cJSON_bool read_head(cbor_reader * const reader, unsigned char * const major, unsigned char * const additional, uint64_t * const value)
+{
+    size_t length = 0;
+    size_t i = 0;
+
+    if (reader->offset >= reader->length)
+    {
+        return false;
+    }
+
+    *major = reader->content[reader->offset] >> 5;
+    *additional = reader->content[reader->offset] & 0x1F;
+    reader->offset++;
+
+    if (*additional < 24)
+    {
+        *value = *additional;
+        return true;
+    }
+    if ((*additional == CBOR_INDEFINITE) && ((*major == CBOR_ARRAY) || (*major == CBOR_MAP) || (*major == CBOR_SIMPLE)))
+    {
+        /* container of unknown length, or the break that ends one */
+        *value = 0;
+        return true;
+    }
+    if (*additional > 27)
+    {
+        /* indefinite length string or reserved */
+        return false;
+    }
+
+    length = (size_t)1 << (*additional - 24);
+    if (length > (reader->length - reader->offset))
+    {
+        return false;
+    }
+    *value = 0;
+    for (i = 0; i < length; i++)
+    {
+        *value = (*value << 8) | reader->content[reader->offset + i];
+    }
+    reader->offset += length;
+
+    return true;
+}
+
+/* zero terminated copy of a text string of length bytes */
+static char *read_text(cbor_reader * const reader, const uint64_t length)
+{
+    char *text = NULL;
+
+    if (length > (reader->length - reader->offset))
+    {
+        return NULL;
+    }
+
+    text = (char*)cJSON_malloc((size_t)length + 1);
+    if (text == NULL)
+    {
+        return NULL;
+    }
+    memcpy(text, reader->content + reader->offset, (size_t)length);
+    text[length] = '\0';
+    reader->offset += (size_t)length;
+
+    return text;
+}
+
+static cJSON *read_value(cbor_reader * const reader, const size_t depth)
+{
+    unsigned char major = 0;
+    unsigned char additional = 0;
+    uint64_t value = 0;
+    uint64_t i = 0;
+    uint32_t single_bits = 0;
+    float single = 0;
+    double d = 0;
+    cJSON *item = NULL;
+    cJSON *child = NULL;
+    char *key = NULL;
+    cJSON_bool indefinite = false;
+
+    if ((depth >= CJSON_NESTING_LIMIT) || !read_head(reader, &major, &additional, &value))
+    {
+        return NULL;
+    }
+
+    switch (major)
+    {
+        case CBOR_UNSIGNED:
+            return cJSON_CreateNumber((double)value);
+
+        case CBOR_NEGATIVE:
+            /* -1 - value with a single rounding, -1.0 - (double)value rounds twice below -2^53 */
+            return cJSON_CreateNumber((value < UINT64_MAX) ? -(double)(value + 1) : -(double)value);
+
+        case CBOR_TEXT:
+            item = cJSON_CreateNull();
+            if (item == NULL)
+            {
+                return NULL;
+            }
+            item->valuestring = read_text(reader, value);
+            if (item->valuestring == NULL)
+            {
+                cJSON_Delete(item);
+                return NULL;
+            }
+            item->type = cJSON_String;
+            return item;
+
+        case CBOR_ARRAY:
+        case CBOR_MAP:
+            /* every element takes at least one byte, this also bounds the loop for bogus counts */
+            indefinite = (additional == CBOR_INDEFINITE);
+            if (!indefinite && (value > (reader->length - reader->offset)))
+            {
+                return NULL;
+            }
+            item = (major == CBOR_ARRAY) ? cJSON_CreateArray() : cJSON_CreateObject();
+            if (item == NULL)
+            {
+                return NULL;
+            }
+            for (i = 0; indefinite || (i < value); i++)
+            {
+                if (indefinite)
+                {
+                    /* elements run up to the break, a streamed message's only end marker */
+                    if (reader->offset >= reader->length)
+                    {
+                        cJSON_Delete(item);
+                        return NULL;
+                    }
+                    if (reader->content[reader->offset] == CBOR_BREAK)
+                    {
+                        reader->offset++;
+                        break;
+                    }
+                }
+                if (major == CBOR_MAP)
+                {
+                    unsigned char key_major = 0;
+                    uint64_t key_length = 0;
+                    if (!read_head(reader, &key_major, &additional, &key_length) || (key_major != CBOR_TEXT) || ((key = read_text(reader, key_length)) == NULL))
+                    {
+                        cJSON_Delete(item);
+                        return NULL;
+                    }
+                }
+                child = read_value(reader, depth + 1);
+                if (child == NULL)
+                {
+                    cJSON_free(key);
+                    cJSON_Delete(item);
+                    return NULL;
+                }
+                child->string = key;
+                key = NULL;
+                cJSON_AddItemToArray(item, child);
+            }
+            return item;
+
+        case CBOR_TAG:
+            /* the tag number is dropped, the tagged item is kept */
+            return read_value(reader, depth + 1);
+
+        case CBOR_SIMPLE:
+            switch (additional)
+            {
+                case CBOR_FALSE:
+                    return cJSON_CreateFalse();
+                case CBOR_TRUE:
+                    return cJSON_CreateTrue();
+                case CBOR_NULL:
+                case CBOR_UNDEFINED:
+                    return cJSON_CreateNull();
+                case CBOR_HALF:
+                    return cJSON_CreateNumber(half_to_double((uint16_t)value));
+                case CBOR_SINGLE:
+                    single_bits = (uint32_t)value;
+                    memcpy(&single, &single_bits, sizeof(single));
+                    return cJSON_CreateNumber((double)single);
+                case CBOR_DOUBLE:
+                    memcpy(&d, &value, sizeof(d));
+                    return cJSON_CreateNumber(d);
+                default:
+                    return NULL;
+            }
+
+        default:
+            /* byte strings have no cJSON counterpart */
+            return NULL;
+    }
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseCbor(const unsigned char *data, size_t length)
+{
+    cbor_reader reader = { NULL, 0, 0 };
+    cJSON *item = NULL;
+
+    if ((data == NULL) || (length == 0))
+    {
+        return NULL;
+    }
+
+    reader.content = data;
+    reader.length = length;
+    item = read_value(&reader, 0);
+    if ((item != NULL) && (reader.offset != reader.length))
+    {
+        /* trailing garbage */
+        cJSON_Delete(item);
+        return NULL;
+    }
+
+    return item;
+}
@@ -0,0 +1,34 @@
+#ifndef cJSON_Cbor__h
+#define cJSON_Cbor__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include "cJSON.h"
+
+/* CBOR (RFC 8949) encoding of cJSON trees, for binary WebSocket frames.
+ * The same tree that cJSON_Print renders as text is written as CBOR: integral numbers become CBOR integers,
+ * other numbers the smallest of half, single or double precision float that holds the value exactly, so no
+ * float is ever converted to text. Numbers with a precision set by cJSON_SetNumberPrecision only have to
+ * survive to that many decimals, which usually makes them single precision floats.
+ * NaN and infinity stay what they are instead of turning into null. Raw items can't be encoded. */
+
+/* Number of bytes cJSON_PrintCbor writes for item, 0 if it can't be encoded. */
+CJSON_PUBLIC(size_t) cJSON_CborLength(const cJSON *item);
+/* Encode item into buffer. Returns the number of bytes written, 0 on failure or if size is too small. */
+CJSON_PUBLIC(size_t) cJSON_PrintCbor(const cJSON *item, unsigned char *buffer, size_t size);
+/* Decode exactly one CBOR item of length bytes into a new tree, free it with cJSON_Delete.
+ * Maps need text string keys. Arrays and maps may have indefinite length (streamed responses end them
+ * with a break). Byte strings, indefinite length strings and simple values other than
+ * false/true/null/undefined are rejected, tags are skipped. Returns NULL on failure. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseCbor(const unsigned char *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+/* cJSON_Patch */
+/* JSON Merge Patch, see cJSON_Patch.h */
+
+#include "cJSON_Patch.h"
+
+/* define our own boolean type */
+#ifdef true
+#undef true
+#endif
+#define true ((cJSON_bool)1)
+
+#ifdef false
+#undef false
+#endif
+#define false ((cJSON_bool)0)
+
+static cJSON_bool is_object(const cJSON * const item)
+{
+    return (item != NULL) && ((item->type & 0xFF) == cJSON_Object);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateMergePatch(const cJSON *from, const cJSON *to)
+{
+    cJSON *patch = NULL;
+    const cJSON *from_child = NULL;
+    const cJSON *to_child = NULL;
+    cJSON *member = NULL;
+
+    if (to == NULL)
+    {
+        return NULL;
+    }
+
+    if (!is_object(from) || !is_object(to))
+    {
+        /* only objects are merged, anything else replaces the target */
+        return cJSON_Duplicate(to, true);
+    }
+
+    patch = cJSON_CreateObject();
+    if (patch == NULL)
+    {
+        return NULL;
+    }
+
+    /* removed members */
+    for (from_child = from->child; from_child != NULL; from_child = from_child->next)
+    {
+        if ((from_child->string != NULL) && (cJSON_GetObjectItemCaseSensitive(to, from_child->string) == NULL))
+        {
+            if (cJSON_AddNullToObject(patch, from_child->string) == NULL)
+            {
+                goto fail;
+            }
+        }
+    }
+
+    /* new and changed members */
+    for (to_child = to->child; to_child != NULL; to_child = to_child->next)
+    {
+        if (to_child->string == NULL)
+        {
+            continue;
+        }
+
+        from_child = cJSON_GetObjectItemCaseSensitive(from, to_child->string);
+        if ((from_child != NULL) && cJSON_Compare(from_child, to_child, true))
+        {
+            continue;
+        }
+
+        member = cJSON_CreateMergePatch(from_child, to_child);
+        if ((member == NULL) || !cJSON_AddItemToObject(patch, to_child->string, member))
+        {
+            cJSON_Delete(member);
+            goto fail;
+        }
+    }
+
+    return patch;
+
+fail:
+    cJSON_Delete(patch);
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ApplyMergePatch(cJSON *target, const cJSON *patch)
+{
+    const cJSON *patch_child = NULL;
+    cJSON *target_child = NULL;
+    cJSON *merged = NULL;
+
+    if (patch == NULL)
+    {
+        return target;
+    }
+
+    if (!is_object(patch))
+    {
+        cJSON_Delete(target);
+        return cJSON_Duplicate(patch, true);
+    }
+
+    if (!is_object(target))
+    {
+        cJSON_Delete(target);
+        target = cJSON_CreateObject();
+        if (target == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    for (patch_child = patch->child; patch_child != NULL; patch_child = patch_child->next)
+    {
+        if (patch_child->string == NULL)
+        {
+            continue;
+        }
+
+        if (cJSON_IsNull(patch_child))
+        {
+            cJSON_DeleteItemFromObjectCaseSensitive(target, patch_child->string);
+            continue;
+        }
+
+        target_child = cJSON_GetObjectItemCaseSensitive(target, patch_child->string);
+        if (is_object(target_child) && is_object(patch_child))
+        {
+            /* merged in place */
+            if (cJSON_ApplyMergePatch(target_child, patch_child) == NULL)
+            {
+                return NULL;
+            }
+            continue;
+        }
+
+        /* applied to nothing, which also drops nulls nested in the patch value */
+        merged = cJSON_ApplyMergePatch(NULL, patch_child);
+        if (merged == NULL)
+        {
+            return NULL;
+        }
+        if (target_child != NULL)
+        {
+            if (!cJSON_ReplaceItemInObjectCaseSensitive(target, patch_child->string, merged))
+            {
+                cJSON_Delete(merged);
+                return NULL;
+            }
+        }
+        else if (!cJSON_AddItemToObject(target, patch_child->string, merged))
+        {
+            cJSON_Delete(merged);
+            return NULL;
+        }
+    }
+
+    return target;
+}
@@ -0,0 +1,28 @@
+#ifndef cJSON_Patch__h
+#define cJSON_Patch__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cJSON.h"
+
+/* JSON Merge Patch (RFC 7386).
+ * A patch is a document shaped like its target that only holds what changed: changed or new members with their
+ * new value, removed members as null. Objects are diffed member by member, everything else (arrays included) is
+ * replaced as a whole, so data that is updated piecewise should be kept in objects, e.g. keyed by id.
+ * Because null means "remove", a member whose new value is null can't be expressed and is removed instead. */
+
+/* Patch that turns from into to. For two objects without differences this is an empty object, which is how
+ * callers tell that nothing changed. Keys are compared case sensitively. Returns NULL if out of memory. */
+CJSON_PUBLIC(cJSON *) cJSON_CreateMergePatch(const cJSON *from, const cJSON *to);
+/* Apply patch to target and return the result, which is target itself unless patch replaces it as a whole
+ * (target is deleted then). target may be NULL. Returns NULL if out of memory, target is in an undefined state then. */
+CJSON_PUBLIC(cJSON *) cJSON_ApplyMergePatch(cJSON *target, const cJSON *patch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,616 @@
+/* cJSON_Sax */
+/* Push style JSON tokenizer, see cJSON_Sax.h */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "cJSON_Sax.h"
+
+/* define our own boolean type */
+#ifdef true
+#undef true
+#endif
+#define true ((cJSON_bool)1)
+
+#ifdef false
+#undef false
+#endif
+#define false ((cJSON_bool)0)
+
+enum
+{
+    SAX_VALUE = 0,     /* expecting any value */
+    SAX_ARRAY_FIRST,   /* after '[': value or ']' */
+    SAX_OBJECT_FIRST,  /* after '{': key or '}' */
+    SAX_KEY,           /* after ',' in an object */
+    SAX_COLON,         /* after a key */
+    SAX_AFTER_VALUE,   /* ',' or the closing bracket of the current container */
+    SAX_STRING,
+    SAX_ESCAPE,
+    SAX_UNICODE,
+    SAX_NUMBER,
+    SAX_LITERAL,
+    SAX_DONE
+};
+
+#define is_whitespace(c) (((c) == ' ') || ((c) == '\t') || ((c) == '\n') || ((c) == '\r'))
+#define is_number_char(c) ((((c) >= '0') && ((c) <= '9')) || ((c) == '-') || ((c) == '+') || ((c) == '.') || ((c) == 'e') || ((c) == 'E'))
+
+CJSON_PUBLIC(void) cJSON_SaxInit(cJSON_SaxParser *parser, const cJSON_SaxCallbacks *callbacks, void *user_data, char *token_buffer, size_t token_buffer_size)
+{
+    if (parser == NULL)
+    {
+        return;
+    }
+
+    memset(parser, '\0', sizeof(cJSON_SaxParser));
+    parser->callbacks = callbacks;
+    parser->user_data = user_data;
+    parser->token = token_buffer;
+    parser->token_size = (token_buffer != NULL) ? token_buffer_size : 0;
+    parser->state = SAX_VALUE;
+    parser->status = cJSON_SaxOk;
+}
+
+static cJSON_bool container_is_object(const cJSON_SaxParser * const parser)
+{
+    size_t level = parser->depth - 1;
+    return (parser->containers[level / 8] & (1 << (level % 8))) != 0;
+}
+
+static cJSON_SaxStatus push_container(cJSON_SaxParser * const parser, cJSON_bool object)
+{
+    size_t level = parser->depth;
+
+    if (level >= CJSON_SAX_NESTING_LIMIT)
+    {
+        return cJSON_SaxTooDeep;
+    }
+
+    if (object)
+    {
+        parser->containers[level / 8] |= (unsigned char)(1 << (level % 8));
+    }
+    else
+    {
+        parser->containers[level / 8] &= (unsigned char)~(1 << (level % 8));
+    }
+    parser->depth++;
+
+    return cJSON_SaxOk;
+}
+
+static cJSON_SaxStatus token_append(cJSON_SaxParser * const parser, unsigned char c)
+{
+    /* keep room for the terminator */
+    if ((parser->token_length + 1) >= parser->token_size)
+    {
+        return cJSON_SaxTokenTooLong;
+    }
+
+    parser->token[parser->token_length++] = (char)c;
+
+    return cJSON_SaxOk;
+}
+
+/* append a unicode codepoint as UTF-8 */
+static cJSON_SaxStatus token_append_codepoint(cJSON_SaxParser * const parser, unsigned int codepoint)
+{
+    unsigned char utf8[4];
+    size_t length = 0;
+    size_t i = 0;
+
+    if (codepoint < 0x80)
+    {
+        utf8[0] = (unsigned char)codepoint;
+        length = 1;
+    }
+    else if (codepoint < 0x800)
+    {
+        utf8[0] = (unsigned char)(0xC0 | (codepoint >> 6));
+        utf8[1] = (unsigned char)(0x80 | (codepoint & 0x3F));
+        length = 2;
+    }
+    else if (codepoint < 0x10000)
+    {
+        utf8[0] = (unsigned char)(0xE0 | (codepoint >> 12));
+        utf8[1] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3F));
+        utf8[2] = (unsigned char)(0x80 | (codepoint & 0x3F));
+        length = 3;
+    }
+    else
+    {
+        utf8[0] = (unsigned char)(0xF0 | (codepoint >> 18));
+        utf8[1] = (unsigned char)(0x80 | ((codepoint >> 12) & 0x3F));
+        utf8[2] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3F));
+        utf8[3] = (unsigned char)(0x80 | (codepoint & 0x3F));
+        length = 4;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        if (token_append(parser, utf8[i]) != cJSON_SaxOk)
+        {
+            return cJSON_SaxTokenTooLong;
+        }
+    }
+
+    return cJSON_SaxOk;
+}
+
+/* a value has been completed, figure out what comes next */
+static void value_done(cJSON_SaxParser * const parser)
+{
+    parser->state = (parser->depth == 0) ? SAX_DONE : SAX_AFTER_VALUE;
+}
+
+static cJSON_SaxStatus finish_string(cJSON_SaxParser * const parser)
+{
+    const cJSON_SaxCallbacks *callbacks = parser->callbacks;
+    cJSON_bool keep_going = true;
+
+    if (parser->high_surrogate != 0)
+    {
+        return cJSON_SaxError; /* unpaired surrogate */
+    }
+
+    parser->token[parser->token_length] = '\0';
+    if (parser->is_key)
+    {
+        if ((callbacks != NULL) && (callbacks->key != NULL))
+        {
+            keep_going = callbacks->key(parser->token, parser->token_length, parser->user_data);
+        }
+        parser->state = SAX_COLON;
+    }
+    else
+    {
+        if ((callbacks != NULL) && (callbacks->string != NULL))
+        {
+            keep_going = callbacks->string(parser->token, parser->token_length, parser->user_data);
+        }
+        value_done(parser);
+    }
+
+    return keep_going ? cJSON_SaxOk : cJSON_SaxAborted;
+}
+
+static cJSON_SaxStatus finish_number(cJSON_SaxParser * const parser)
+{
+    const cJSON_SaxCallbacks *callbacks = parser->callbacks;
+    char *after_end = NULL;
+    double number = 0;
+
+    parser->token[parser->token_length] = '\0';
+    number = strtod(parser->token, &after_end);
+    if ((parser->token_length == 0) || (after_end != (parser->token + parser->token_length)))
+    {
+        return cJSON_SaxError;
+    }
+
+    value_done(parser);
+    if ((callbacks != NULL) && (callbacks->number != NULL) && !callbacks->number(number, parser->user_data))
+    {
+        return cJSON_SaxAborted;
+    }
+
+    return cJSON_SaxOk;
+}
+
+static cJSON_SaxStatus finish_literal(cJSON_SaxParser * const parser)
+{
+    const cJSON_SaxCallbacks *callbacks = parser->callbacks;
+    cJSON_bool keep_going = true;
+
+    value_done(parser);
+    if (callbacks == NULL)
+    {
+        return cJSON_SaxOk;
+    }
+
+    if (parser->literal[0] == 'n')
+    {
+        if (callbacks->null != NULL)
+        {
+            keep_going = callbacks->null(parser->user_data);
+        }
+    }
+    else if (callbacks->boolean != NULL)
+    {
+        keep_going = callbacks->boolean((parser->literal[0] == 't') ? true : false, parser->user_data);
+    }
+
+    return keep_going ? cJSON_SaxOk : cJSON_SaxAborted;
+}
+
+/* c is the first character of a value */
+static cJSON_SaxStatus begin_value(cJSON_SaxParser * const parser, unsigned char c)
+{
+    const cJSON_SaxCallbacks *callbacks = parser->callbacks;
+    cJSON_SaxStatus status = cJSON_SaxOk;
+
+    switch (c)
+    {
+        case '{':
+            status = push_container(parser, true);
+            if (status != cJSON_SaxOk)
+            {
+                return status;
+            }
+            parser->state = SAX_OBJECT_FIRST;
+            if ((callbacks != NULL) && (callbacks->start_object != NULL) && !callbacks->start_object(parser->user_data))
+            {
+                return cJSON_SaxAborted;
+            }
+            return cJSON_SaxOk;
+
+        case '[':
+            status = push_container(parser, false);
+            if (status != cJSON_SaxOk)
+            {
+                return status;
+            }
+            parser->state = SAX_ARRAY_FIRST;
+            if ((callbacks != NULL) && (callbacks->start_array != NULL) && !callbacks->start_array(parser->user_data))
+            {
+                return cJSON_SaxAborted;
+            }
+            return cJSON_SaxOk;
+
+        case '\"':
+            parser->token_length = 0;
+            parser->is_key = false;
+            parser->state = SAX_STRING;
+            return cJSON_SaxOk;
+
+        case 't':
+            parser->literal = "true";
+            break;
+        case 'f':
+            parser->literal = "false";
+            break;
+        case 'n':
+            parser->literal = "null";
+            break;
+
+        default:
+            if ((c == '-') || ((c >= '0') && (c <= '9')))
+            {
+                parser->token_length = 0;
+                parser->state = SAX_NUMBER;
+                return token_append(parser, c);
+            }
+            return cJSON_SaxError;
+    }
+
+    parser->literal_position = 1;
+    parser->state = SAX_LITERAL;
+
+    return cJSON_SaxOk;
+}
+
+/* c is ']' or '}' */
+static cJSON_SaxStatus end_container(cJSON_SaxParser * const parser, unsigned char c)
+{
+    const cJSON_SaxCallbacks *callbacks = parser->callbacks;
+    cJSON_bool object = false;
+    cJSON_bool keep_going = true;
+
+    if (parser->depth == 0)
+    {
+        return cJSON_SaxError;
+    }
+
+    object = container_is_object(parser);
+    if ((object && (c != '}')) || (!object && (c != ']')))
+    {
+        return cJSON_SaxError; /* mismatched bracket */
+    }
+
+    parser->depth--;
+    value_done(parser);
+    if (callbacks != NULL)
+    {
+        if (object && (callbacks->end_object != NULL))
+        {
+            keep_going = callbacks->end_object(parser->user_data);
+        }
+        else if (!object && (callbacks->end_array != NULL))
+        {
+            keep_going = callbacks->end_array(parser->user_data);
+        }
+    }
+
+    return keep_going ? cJSON_SaxOk : cJSON_SaxAborted;
+}
+
+static cJSON_SaxStatus handle_escape(cJSON_SaxParser * const parser, unsigned char c)
+{
+    unsigned char unescaped = 0;
+
+    if ((parser->high_surrogate != 0) && (c != 'u'))
+    {
+        return cJSON_SaxError; /* high surrogate must be followed by \uXXXX */
+    }
+
+    switch (c)
+    {
+        case 'b':
+            unescaped = '\b';
+            break;
+        case 'f':
+            unescaped = '\f';
+            break;
+        case 'n':
+            unescaped = '\n';
+            break;
+        case 'r':
+            unescaped = '\r';
+            break;
+        case 't':
+            unescaped = '\t';
+            break;
+        case '\"':
+        case '\\':
+        case '/':
+            unescaped = c;
+            break;
+        case 'u':
+            parser->codepoint = 0;
+            parser->hex_digits = 0;
+            parser->state = SAX_UNICODE;
+            return cJSON_SaxOk;
+        default:
+            return cJSON_SaxError;
+    }
+
+    parser->state = SAX_STRING;
+    return token_append(parser, unescaped);
+}
+
+static cJSON_SaxStatus handle_hex_digit(cJSON_SaxParser * const parser, unsigned char c)
+{
+    unsigned int codepoint = 0;
+
+    if ((c >= '0') && (c <= '9'))
+    {
+        parser->codepoint = (parser->codepoint << 4) | (unsigned int)(c - '0');
+    }
+    else if ((c >= 'A') && (c <= 'F'))
+    {
+        parser->codepoint = (parser->codepoint << 4) | (unsigned int)(10 + c - 'A');
+    }
+    else if ((c >= 'a') && (c <= 'f'))
+    {
+        parser->codepoint = (parser->codepoint << 4) | (unsigned int)(10 + c - 'a');
+    }
+    else
+    {
+        return cJSON_SaxError;
+    }
+
+    if (++parser->hex_digits < 4)
+    {
+        return cJSON_SaxOk;
+    }
+
+    parser->state = SAX_STRING;
+    codepoint = parser->codepoint;
+    if ((codepoint >= 0xD800) && (codepoint <= 0xDBFF))
+    {
+        if (parser->high_surrogate != 0)
+        {
+            return cJSON_SaxError;
+        }
+        parser->high_surrogate = codepoint;
+        return cJSON_SaxOk;
+    }
+
+    if ((codepoint >= 0xDC00) && (codepoint <= 0xDFFF))
+    {
+        if (parser->high_surrogate == 0)
+        {
+            return cJSON_SaxError; /* low surrogate without a high one */
+        }
+        codepoint = 0x10000 + (((parser->high_surrogate & 0x3FF) << 10) | (codepoint & 0x3FF));
+        parser->high_surrogate = 0;
+    }
+    else if (parser->high_surrogate != 0)
+    {
+        return cJSON_SaxError;
+    }
+
+    return token_append_codepoint(parser, codepoint);
+}
+
+CJSON_PUBLIC(cJSON_SaxStatus) cJSON_SaxFeed(cJSON_SaxParser *parser, const char *chunk, size_t length)
+{
+    const unsigned char *input = (const unsigned char*)chunk;
+    const unsigned char *input_end = input + length;
+    cJSON_SaxStatus status = cJSON_SaxOk;
+
+    if ((parser == NULL) || (parser->token == NULL) || ((chunk == NULL) && (length > 0)))
+    {
+        return cJSON_SaxError;
+    }
+
+    if ((parser->status != cJSON_SaxOk) && (parser->status != cJSON_SaxDone))
+    {
+        return parser->status;
+    }
+
+    while ((input < input_end) && (status == cJSON_SaxOk))
+    {
+        unsigned char c = *input;
+
+        switch (parser->state)
+        {
+            case SAX_STRING:
+                /* copy runs of plain characters without going through the state switch */
+                while ((c != '\"') && (c != '\\'))
+                {
+                    if (parser->high_surrogate != 0)
+                    {
+                        status = cJSON_SaxError;
+                        break;
+                    }
+                    status = token_append(parser, c);
+                    if ((status != cJSON_SaxOk) || (++input == input_end))
+                    {
+                        break;
+                    }
+                    c = *input;
+                }
+                if ((status != cJSON_SaxOk) || (input == input_end))
+                {
+                    continue;
+                }
+                status = (c == '\"') ? finish_string(parser) : cJSON_SaxOk;
+                if (c == '\\')
+                {
+                    parser->state = SAX_ESCAPE;
+                }
+                break;
+
+            case SAX_ESCAPE:
+                status = handle_escape(parser, c);
+                break;
+
+            case SAX_UNICODE:
+                status = handle_hex_digit(parser, c);
+                break;
+
+            case SAX_NUMBER:
+                if (is_number_char(c))
+                {
+                    status = token_append(parser, c);
+                    break;
+                }
+                /* the number ended, c has to be looked at again in the new state */
+                status = finish_number(parser);
+                continue;
+
+            case SAX_LITERAL:
+                if (c != (unsigned char)parser->literal[parser->literal_position])
+                {
+                    status = cJSON_SaxError;
+                    continue;
+                }
+                if (parser->literal[++parser->literal_position] == '\0')
+                {
+                    status = finish_literal(parser);
+                }
+                break;
+
+            case SAX_VALUE:
+            case SAX_ARRAY_FIRST:
+                if (is_whitespace(c))
+                {
+                    break;
+                }
+                if ((parser->state == SAX_ARRAY_FIRST) && (c == ']'))
+                {
+                    status = end_container(parser, c);
+                    break;
+                }
+                status = begin_value(parser, c);
+                break;
+
+            case SAX_OBJECT_FIRST:
+            case SAX_KEY:
+                if (is_whitespace(c))
+                {
+                    break;
+                }
+                if ((parser->state == SAX_OBJECT_FIRST) && (c == '}'))
+                {
+                    status = end_container(parser, c);
+                    break;
+                }
+                if (c != '\"')
+                {
+                    status = cJSON_SaxError;
+                    continue;
+                }
+                parser->token_length = 0;
+                parser->is_key = true;
+                parser->state = SAX_STRING;
+                break;
+
+            case SAX_COLON:
+                if (is_whitespace(c))
+                {
+                    break;
+                }
+                if (c != ':')
+                {
+                    status = cJSON_SaxError;
+                    continue;
+                }
+                parser->state = SAX_VALUE;
+                break;
+
+            case SAX_AFTER_VALUE:
+                if (is_whitespace(c))
+                {
+                    break;
+                }
+                if (c == ',')
+                {
+                    parser->state = container_is_object(parser) ? SAX_KEY : SAX_VALUE;
+                    break;
+                }
+                status = end_container(parser, c);
+                break;
+
+            case SAX_DONE:
+            default:
+                if (!is_whitespace(c))
+                {
+                    status = cJSON_SaxError; /* garbage after the document */
+                    continue;
+                }
+                break;
+        }
+
+        if (status == cJSON_SaxOk)
+        {
+            input++;
+        }
+    }
+
+    parser->position += (size_t)(input - (const unsigned char*)chunk);
+    if ((status == cJSON_SaxOk) && (parser->state == SAX_DONE))
+    {
+        status = cJSON_SaxDone;
+    }
+    parser->status = status;
+
+    return status;
+}
+
+CJSON_PUBLIC(cJSON_SaxStatus) cJSON_SaxFinish(cJSON_SaxParser *parser)
+{
+    if (parser == NULL)
+    {
+        return cJSON_SaxError;
+    }
+
+    if (parser->status != cJSON_SaxOk)
+    {
+        return parser->status;
+    }
+
+    if ((parser->state == SAX_NUMBER) && (parser->depth == 0))
+    {
+        parser->status = finish_number(parser);
+        if (parser->status != cJSON_SaxOk)
+        {
+            return parser->status;
+        }
+    }
+
+    parser->status = (parser->state == SAX_DONE) ? cJSON_SaxDone : cJSON_SaxError;
+
+    return parser->status;
+}
@@ -0,0 +1,82 @@
+#ifndef cJSON_Sax__h
+#define cJSON_Sax__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cJSON.h"
+
+/* Push (SAX style) JSON tokenizer.
+ * The input can be fed in chunks of any size, e.g. straight from httpd_req_recv(), and the parser reports
+ * keys and values through callbacks as soon as they are complete. No tree is built: the memory used is the
+ * parser struct plus a caller supplied token buffer, whatever the size of the document.
+ * A single string or number must fit into the token buffer, longer ones fail with cJSON_SaxTokenTooLong. */
+
+/* Maximum nesting of arrays/objects, one bit of state per level. */
+#ifndef CJSON_SAX_NESTING_LIMIT
+#define CJSON_SAX_NESTING_LIMIT 32
+#endif
+
+typedef enum
+{
+    cJSON_SaxOk = 0,          /* chunk consumed, document not complete yet */
+    cJSON_SaxDone,            /* a complete top level value has been parsed */
+    cJSON_SaxError,           /* invalid JSON */
+    cJSON_SaxTokenTooLong,    /* a string or number does not fit into the token buffer */
+    cJSON_SaxTooDeep,         /* CJSON_SAX_NESTING_LIMIT exceeded */
+    cJSON_SaxAborted          /* a callback returned false */
+} cJSON_SaxStatus;
+
+/* Every callback is optional. Returning false aborts the parse.
+ * Strings are unescaped UTF-8, zero terminated, and only valid for the duration of the call. */
+typedef struct cJSON_SaxCallbacks
+{
+    cJSON_bool (*start_object)(void *user_data);
+    cJSON_bool (*end_object)(void *user_data);
+    cJSON_bool (*start_array)(void *user_data);
+    cJSON_bool (*end_array)(void *user_data);
+    cJSON_bool (*key)(const char *key, size_t length, void *user_data);
+    cJSON_bool (*string)(const char *value, size_t length, void *user_data);
+    cJSON_bool (*number)(double value, void *user_data);
+    cJSON_bool (*boolean)(cJSON_bool value, void *user_data);
+    cJSON_bool (*null)(void *user_data);
+} cJSON_SaxCallbacks;
+
+/* Parser state, treat as opaque. */
+typedef struct cJSON_SaxParser
+{
+    const cJSON_SaxCallbacks *callbacks;
+    void *user_data;
+    char *token;
+    size_t token_size;
+    size_t token_length;
+    unsigned char containers[(CJSON_SAX_NESTING_LIMIT + 7) / 8]; /* bit set: object, clear: array */
+    size_t depth;
+    int state;
+    int return_state;
+    const char *literal;
+    size_t literal_position;
+    unsigned int codepoint;
+    unsigned int high_surrogate;
+    unsigned char hex_digits;
+    cJSON_bool is_key;
+    cJSON_SaxStatus status;
+    size_t position; /* number of bytes consumed, points at the offending byte on failure */
+} cJSON_SaxParser;
+
+/* Prepare parser for a new document. token_buffer must stay valid while the parser is used. */
+CJSON_PUBLIC(void) cJSON_SaxInit(cJSON_SaxParser *parser, const cJSON_SaxCallbacks *callbacks, void *user_data, char *token_buffer, size_t token_buffer_size);
+/* Feed the next chunk. Returns cJSON_SaxOk while more input is expected, cJSON_SaxDone once the document is
+ * complete (trailing whitespace is still accepted) or the error that stopped the parse. Errors are sticky. */
+CJSON_PUBLIC(cJSON_SaxStatus) cJSON_SaxFeed(cJSON_SaxParser *parser, const char *chunk, size_t length);
+/* Signal the end of the input. Completes a top level number and returns cJSON_SaxDone if the document
+ * is complete, cJSON_SaxError if it was truncated. */
+CJSON_PUBLIC(cJSON_SaxStatus) cJSON_SaxFinish(cJSON_SaxParser *parser);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,6 +11,7 @@
 #include "esp_log.h"
 #include "cJSON.h"
 #include "jw_server.h"
+#include "jw_metrics.h"
 
 #define TAG "JW_ESPNOW"
 #define JW_ESPNOW_EVENT_QUEUE_SIZE 10
@@ -33,10 +34,17 @@ struct jw_espnow_context {
 // Static context instance
 static jw_espnow_context_t *jw_espnow_context = NULL;
 
+// Updated from the Wi-Fi task's receive callback, so only atomics
+static JW_METRICS_COUNTER_DEFINE(jw_espnow_received, "jw_espnow_messages_total", "result=\"queued\"", "ESP-NOW messages received");
+static JW_METRICS_COUNTER_DEFINE(jw_espnow_rejected, "jw_espnow_messages_total", "result=\"rejected\"", "ESP-NOW messages received");
+static JW_METRICS_COUNTER_DEFINE(jw_espnow_dropped, "jw_espnow_messages_total", "result=\"dropped\"", "ESP-NOW messages received");
+static JW_METRICS_HISTOGRAM_DEFINE(jw_espnow_receive_seconds, "jw_espnow_receive_seconds", NULL, "ESP-NOW receive callback duration");
+
 static void jw_espnow_run_peering_task(void *params);
 static void jw_espnow_handle_receive_callback(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
 static void jw_espnow_handle_send_callback(const uint8_t *mac_addr, esp_now_send_status_t status);
 static void send_found_peers_notification(cJSON *peers_array);
+static void send_telemetry_notification(const uint8_t *mac_address, const jw_peer_data_t *data);
 
 esp_err_t jw_espnow_initialize(void) {
     if (jw_espnow_context != NULL) {
@@ -44,6 +52,11 @@ esp_err_t jw_espnow_initialize(void) {
         return ESP_OK;
     }
 
+    jw_metrics_register(&jw_espnow_received);
+    jw_metrics_register(&jw_espnow_rejected);
+    jw_metrics_register(&jw_espnow_dropped);
+    jw_metrics_register(&jw_espnow_receive_seconds);
+
     jw_espnow_context = heap_caps_malloc(sizeof(jw_espnow_context_t), MALLOC_CAP_SPIRAM);
     if (!jw_espnow_context) {
         ESP_LOGE(TAG, "Failed to allocate context");
@@ -186,6 +199,26 @@ static void send_found_peers_notification(cJSON *peers_array) {
     // jw_server_notify_found_peers(msg);
 }
 
+// Only WS clients subscribed to telemetry/<mac> (or a wildcard covering it) get the reading
+static void send_telemetry_notification(const uint8_t *mac_address, const jw_peer_data_t *data) {
+    char mac_str[18];
+    char topic[32];
+    snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(mac_address));
+    snprintf(topic, sizeof(topic), "telemetry/%s", mac_str);
+    cJSON *msg = cJSON_CreateObject();
+    cJSON_AddNumberToObject(msg, "type", 1);
+    cJSON_AddStringToObject(msg, "key", "telemetry");
+    cJSON *val = cJSON_AddObjectToObject(msg, "val");
+    cJSON_AddStringToObject(val, "mac", mac_str);
+    cJSON_AddNumberToObject(val, "timestamp", data->timestamp);
+    cJSON *values = cJSON_CreateFloatArray(data->sensor_values, 3);
+    cJSON_SetNumberPrecision(values, 2);
+    cJSON_AddItemToObject(val, "values", values);
+    cJSON_AddBoolToObject(val, "relay", data->relay_state);
+    cJSON_AddBoolToObject(val, "switch", data->switch_state);
+    jw_server_publish(topic, mac_str, msg); // Keyed by MAC, a slow client gets the latest reading only
+}
+
 static void jw_espnow_run_peering_task(void *params) {
     jw_espnow_message_t msg;
     uint8_t controller_mac[ESP_NOW_ETH_ALEN];
@@ -216,19 +249,17 @@ static void jw_espnow_run_peering_task(void *params) {
                             break;
                         }
                         bool exists = false;
-                        for (int i = 0; i < cJSON_GetArraySize(found_peers); i++) {
-                            cJSON *peer = cJSON_GetArrayItem(found_peers, i);
-                            char mac_str[18];
-                            snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(msg.source_mac));
-                            if (strcmp(cJSON_GetObjectItem(peer, "mac")->valuestring, mac_str) == 0) {
+                        char mac_str[18];
+                        snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(msg.source_mac));
+                        cJSON *found = NULL;
+                        cJSON_ArrayForEach(found, found_peers) { // One walk, cJSON_GetArrayItem(i) restarts from the head
+                            if (strcmp(cJSON_GetObjectItem(found, "mac")->valuestring, mac_str) == 0) {
                                 exists = true;
                                 break;
                             }
                         }
                         if (!exists) {
                             cJSON *peer = cJSON_CreateObject();
-                            char mac_str[18];
-                            snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(msg.source_mac));
                             cJSON_AddStringToObject(peer, "mac", mac_str);
                             cJSON_AddStringToObject(peer, "name", msg.payload.peering.peer_name);
                             cJSON_AddNumberToObject(peer, "type", msg.payload.peering.peer_type);
@@ -272,6 +303,7 @@ static void jw_espnow_run_peering_task(void *params) {
                 case JW_ESPNOW_MSG_TYPE_DATA:
                     ESP_LOGI(TAG, "Received DATA from " MACSTR, MAC2STR(msg.source_mac));
                     jw_peers_update_data(msg.source_mac, &msg.payload.data);
+                    send_telemetry_notification(msg.source_mac, &msg.payload.data);
                     break;
                 default:
                     ESP_LOGW(TAG, "Unhandled message type %d from " MACSTR, msg.msg_type, MAC2STR(msg.source_mac));
@@ -297,8 +329,10 @@ static void jw_espnow_run_peering_task(void *params) {
 }
 
 static void jw_espnow_handle_receive_callback(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    int64_t start = jw_metrics_start();
     if (!jw_espnow_context || len < sizeof(jw_espnow_message_t)) {
         ESP_LOGE(TAG, "Invalid receive data");
+        jw_metrics_inc(&jw_espnow_rejected);
         return;
     }
 
@@ -307,11 +341,17 @@ static void jw_espnow_handle_receive_callback(const esp_now_recv_info_t *recv_in
     memcpy(msg.source_mac, recv_info->src_addr, ESP_NOW_ETH_ALEN);
     if (msg.version != 1) {
         ESP_LOGW(TAG, "Ignoring message with version %d", msg.version);
+        jw_metrics_inc(&jw_espnow_rejected);
         return;
     }
     if (xQueueSend(jw_espnow_context->event_queue, &msg, pdMS_TO_TICKS(100)) != pdTRUE) {
         ESP_LOGW(TAG, "Event queue full");
+        jw_metrics_inc(&jw_espnow_dropped);
+    }
+    else {
+        jw_metrics_inc(&jw_espnow_received);
     }
+    jw_metrics_observe_since(&jw_espnow_receive_seconds, start); // Mostly time blocked on a full queue
 }
 
 static void jw_espnow_handle_send_callback(const uint8_t *mac_addr, esp_now_send_status_t status) {
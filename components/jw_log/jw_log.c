@@ -8,6 +8,7 @@
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "jw_sdcard.h"
+#include "jw_metrics.h"
 
 #define TAG "JW_LOG"
 #define JW_LOG_QUEUE_SIZE 20
@@ -24,6 +25,9 @@ struct jw_log_context {
 
 static jw_log_context_t *jw_log_context = NULL;
 
+static JW_METRICS_HISTOGRAM_DEFINE(jw_log_write_seconds, "jw_log_write_seconds", NULL, "Log line append latency");
+static JW_METRICS_COUNTER_DEFINE(jw_log_fallback_total, "jw_log_fallback_total", NULL, "Log lines that went to the NVS fallback");
+
 static void jw_log_run_task(void *params);
 static void save_fallback_to_nvs(void);
 static void add_fallback_log(const char *message);
@@ -34,6 +38,9 @@ esp_err_t jw_log_init(void) {
         return ESP_OK;
     }
 
+    jw_metrics_register(&jw_log_write_seconds);
+    jw_metrics_register(&jw_log_fallback_total);
+
     jw_log_context = heap_caps_malloc(sizeof(jw_log_context_t), MALLOC_CAP_SPIRAM);
     if (!jw_log_context) {
         ESP_LOGE(TAG, "Failed to allocate context");
@@ -103,6 +110,7 @@ esp_err_t jw_log_write(jw_log_level_t level, const char *path, const char *messa
         return ESP_ERR_INVALID_ARG;
     }
 
+    int64_t start = jw_metrics_start();
     char full_message[128];
     const char *level_str = (level == JW_LOG_INFO) ? "INFO" : (level == JW_LOG_WARNING) ? "WARN" : "ERROR";
     snprintf(full_message, sizeof(full_message), "[%s] %s", level_str, message);
@@ -111,11 +119,14 @@ esp_err_t jw_log_write(jw_log_level_t level, const char *path, const char *messa
     if (f) {
         fprintf(f, "%s\n", full_message);
         fclose(f);
+        jw_metrics_observe_since(&jw_log_write_seconds, start);
         return ESP_OK;
     }
     else {
         ESP_LOGW(TAG, "Failed to write to SD card at %s", path);
         add_fallback_log(full_message);
+        jw_metrics_observe_since(&jw_log_write_seconds, start);
+        jw_metrics_inc(&jw_log_fallback_total);
         return ESP_FAIL;
     }
 }
@@ -0,0 +1,141 @@
+#include "jw_metrics.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Upper bounds of the latency buckets, from a fast HTTP handler to a slow SD card write
+static const uint32_t jw_metrics_bounds[JW_METRICS_BUCKETS] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000, 1000000
+};
+static const char *jw_metrics_bounds_le[JW_METRICS_BUCKETS] = {
+    "0.0001", "0.00025", "0.0005", "0.001", "0.0025", "0.005", "0.01", "0.025", "0.1", "1"
+};
+static const char *jw_metrics_type_names[] = { "counter", "gauge", "histogram" };
+
+typedef struct {
+    char *scratch;
+    size_t size;
+    size_t len;
+    jw_metrics_sink_t sink;
+    void *user_data;
+    bool failed;
+} jw_metrics_output_t;
+
+static jw_metrics_t *jw_metrics_head = NULL;
+static portMUX_TYPE jw_metrics_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void jw_metrics_register(jw_metrics_t *metric) {
+    taskENTER_CRITICAL(&jw_metrics_lock);
+    jw_metrics_t **link = &jw_metrics_head;
+    jw_metrics_t **family = NULL;
+    for (; *link; link = &(*link)->next) {
+        if (*link == metric) {
+            taskEXIT_CRITICAL(&jw_metrics_lock);
+            return;
+        }
+        if (strcmp((*link)->name, metric->name) == 0) family = &(*link)->next; // After the last one of its family
+    }
+    if (!family) family = link;
+    metric->next = *family;
+    // jw_metrics_write walks the list without the lock, the metric is complete before it is linked
+    atomic_thread_fence(memory_order_release);
+    *family = metric;
+    taskEXIT_CRITICAL(&jw_metrics_lock);
+}
+
+void jw_metrics_observe(jw_metrics_t *metric, uint32_t us) {
+    jw_metrics_histogram_shard_t *shard = &metric->histogram[esp_cpu_get_core_id()];
+    size_t bucket = 0;
+    while (bucket < JW_METRICS_BUCKETS && us > jw_metrics_bounds[bucket]) bucket++;
+    atomic_fetch_add_explicit(&shard->buckets[bucket], 1, memory_order_relaxed);
+    uint32_t low = atomic_fetch_add_explicit(&shard->sum_low, us, memory_order_relaxed);
+    if ((uint32_t)(low + us) < low) atomic_fetch_add_explicit(&shard->sum_high, 1, memory_order_relaxed); // Carry
+}
+
+static bool jw_metrics_flush(jw_metrics_output_t *out) {
+    if (out->len > 0 && !out->failed && !out->sink(out->scratch, out->len, out->user_data)) out->failed = true;
+    out->len = 0;
+    return !out->failed;
+}
+
+// Appends one line, the buffer goes to the sink first when the line doesn't fit behind what is already there
+static void jw_metrics_printf(jw_metrics_output_t *out, const char *format, ...) {
+    if (out->failed) return;
+    va_list args;
+    va_start(args, format);
+    va_list retry;
+    va_copy(retry, args);
+    int len = vsnprintf(out->scratch + out->len, out->size - out->len, format, args);
+    if (len >= 0 && (size_t)len >= out->size - out->len && jw_metrics_flush(out)) {
+        len = vsnprintf(out->scratch, out->size, format, retry);
+    }
+    va_end(retry);
+    va_end(args);
+    if (len < 0 || (size_t)len >= out->size - out->len) {
+        out->failed = true; // Longer than the whole buffer, not worth splitting
+        return;
+    }
+    out->len += len;
+}
+
+static void jw_metrics_write_histogram(jw_metrics_output_t *out, const jw_metrics_t *metric) {
+    const char *labels = metric->labels ? metric->labels : "";
+    const char *separator = metric->labels ? "," : "";
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    for (size_t shard = 0; shard < JW_METRICS_SHARDS; shard++) {
+        const jw_metrics_histogram_shard_t *h = &metric->histogram[shard];
+        sum += ((uint64_t)atomic_load_explicit(&h->sum_high, memory_order_relaxed) << 32) |
+               atomic_load_explicit(&h->sum_low, memory_order_relaxed);
+    }
+    for (size_t bucket = 0; bucket <= JW_METRICS_BUCKETS; bucket++) {
+        for (size_t shard = 0; shard < JW_METRICS_SHARDS; shard++) {
+            count += atomic_load_explicit(&metric->histogram[shard].buckets[bucket], memory_order_relaxed);
+        }
+        const char *le = bucket < JW_METRICS_BUCKETS ? jw_metrics_bounds_le[bucket] : "+Inf";
+        jw_metrics_printf(out, "%s_bucket{%s%sle=\"%s\"} %" PRIu64 "\n", metric->name, labels, separator, le, count);
+    }
+    // _count is the +Inf bucket, so the two agree even when an observation lands mid-scrape
+    const char *open = metric->labels ? "{" : "";
+    const char *close = metric->labels ? "}" : "";
+    jw_metrics_printf(out, "%s_sum%s%s%s %" PRIu64 ".%06" PRIu64 "\n", metric->name, open, labels, close,
+                      sum / 1000000, sum % 1000000);
+    jw_metrics_printf(out, "%s_count%s%s%s %" PRIu64 "\n", metric->name, open, labels, close, count);
+}
+
+esp_err_t jw_metrics_write(char *scratch, size_t size, jw_metrics_sink_t sink, void *user_data) {
+    if (size < JW_METRICS_LINE_MAX) return ESP_ERR_INVALID_SIZE;
+    jw_metrics_output_t out = { .scratch = scratch, .size = size, .sink = sink, .user_data = user_data };
+    const char *family = NULL;
+    jw_metrics_t *metric = jw_metrics_head;
+    atomic_thread_fence(memory_order_acquire);
+    for (; metric && !out.failed; metric = metric->next) {
+        if (!family || strcmp(family, metric->name) != 0) {
+            family = metric->name;
+            jw_metrics_printf(&out, "# HELP %s %s\n", metric->name, metric->help);
+            jw_metrics_printf(&out, "# TYPE %s %s\n", metric->name, jw_metrics_type_names[metric->type]);
+        }
+        const char *open = metric->labels ? "{" : "";
+        const char *labels = metric->labels ? metric->labels : "";
+        const char *close = metric->labels ? "}" : "";
+        if (metric->type == JW_METRICS_COUNTER) {
+            uint64_t total = 0;
+            for (size_t shard = 0; shard < JW_METRICS_SHARDS; shard++) {
+                total += atomic_load_explicit(&metric->counter[shard], memory_order_relaxed);
+            }
+            jw_metrics_printf(&out, "%s%s%s%s %" PRIu64 "\n", metric->name, open, labels, close, total);
+        }
+        else if (metric->type == JW_METRICS_GAUGE) {
+            int32_t value = atomic_load_explicit(&metric->gauge, memory_order_relaxed);
+            jw_metrics_printf(&out, "%s%s%s%s %" PRId32 "\n", metric->name, open, labels, close, value);
+        }
+        else {
+            jw_metrics_write_histogram(&out, metric);
+        }
+    }
+    jw_metrics_flush(&out);
+    return out.failed ? ESP_FAIL : ESP_OK;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifndef JW_METRICS_H
+#define JW_METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "soc/soc_caps.h"
+
+/** @brief Per-core copies of every counter and histogram, a core only ever updates its own */
+#define JW_METRICS_SHARDS SOC_CPU_CORES_NUM
+
+/** @brief Latency histogram buckets, upper bounds in microseconds (see jw_metrics.c), plus +Inf */
+#define JW_METRICS_BUCKETS 10
+
+/** @brief Scratch buffer jw_metrics_write needs at least, one exposition line */
+#define JW_METRICS_LINE_MAX 192
+
+typedef enum {
+    JW_METRICS_COUNTER = 0,
+    JW_METRICS_GAUGE,
+    JW_METRICS_HISTOGRAM
+} jw_metrics_type_t;
+
+typedef struct {
+    atomic_uint_least32_t buckets[JW_METRICS_BUCKETS + 1]; // Observations per bucket, not cumulative
+    atomic_uint_least32_t sum_low;                          // Sum in microseconds, carried into sum_high
+    atomic_uint_least32_t sum_high;
+} jw_metrics_histogram_shard_t;
+
+/**
+ * @brief One metric, defined statically by the module it measures
+ *
+ * Define it with JW_METRICS_COUNTER_DEFINE, JW_METRICS_GAUGE_DEFINE or JW_METRICS_HISTOGRAM_DEFINE and hand it to
+ * jw_metrics_register once. Metrics sharing a name (one family, different labels) are listed together.
+ */
+typedef struct jw_metrics {
+    const char *name;              // Prometheus name, "jw_sdcard_write_seconds"
+    const char *help;
+    const char *labels;            // Without braces, "handler=\"root\"", or NULL
+    jw_metrics_type_t type;
+    struct jw_metrics *next;       // Registry list, only ever appended to
+    union {
+        atomic_uint_least32_t counter[JW_METRICS_SHARDS];
+        atomic_int_least32_t gauge;
+        jw_metrics_histogram_shard_t histogram[JW_METRICS_SHARDS];
+    };
+} jw_metrics_t;
+
+#define JW_METRICS_COUNTER_DEFINE(var, metric_name, metric_labels, metric_help) \
+    jw_metrics_t var = { .name = metric_name, .help = metric_help, .labels = metric_labels, .type = JW_METRICS_COUNTER }
+#define JW_METRICS_GAUGE_DEFINE(var, metric_name, metric_labels, metric_help) \
+    jw_metrics_t var = { .name = metric_name, .help = metric_help, .labels = metric_labels, .type = JW_METRICS_GAUGE }
+#define JW_METRICS_HISTOGRAM_DEFINE(var, metric_name, metric_labels, metric_help) \
+    jw_metrics_t var = { .name = metric_name, .help = metric_help, .labels = metric_labels, .type = JW_METRICS_HISTOGRAM }
+
+/**
+ * @brief Sink for jw_metrics_write
+ * @return bool False stops the output
+ */
+typedef bool (*jw_metrics_sink_t)(const char *data, size_t len, void *user_data);
+
+/**
+ * @brief Add a metric to the registry
+ * @param metric Statically allocated metric, registering it again does nothing
+ *
+ * Updates work whether or not the metric is registered, registering only makes it part of jw_metrics_write.
+ */
+void jw_metrics_register(jw_metrics_t *metric);
+
+/**
+ * @brief Record one latency observation
+ * @param metric Histogram
+ * @param us Duration in microseconds
+ */
+void jw_metrics_observe(jw_metrics_t *metric, uint32_t us);
+
+/**
+ * @brief Write every registered metric in the Prometheus text format
+ * @param scratch Buffer the output is assembled in, at least JW_METRICS_LINE_MAX bytes
+ * @param size Size of scratch
+ * @param sink Called with each full buffer and with the rest at the end
+ * @param user_data Passed to sink
+ * @return esp_err_t ESP_OK, ESP_ERR_INVALID_SIZE for a short buffer, ESP_FAIL when the sink failed
+ *
+ * Shards are read without stopping writers, so a scrape racing an update may miss that update. It shows up in
+ * the next scrape.
+ */
+esp_err_t jw_metrics_write(char *scratch, size_t size, jw_metrics_sink_t sink, void *user_data);
+
+static inline void jw_metrics_add(jw_metrics_t *metric, uint32_t value) {
+    atomic_fetch_add_explicit(&metric->counter[esp_cpu_get_core_id()], value, memory_order_relaxed);
+}
+
+static inline void jw_metrics_inc(jw_metrics_t *metric) {
+    jw_metrics_add(metric, 1);
+}
+
+static inline void jw_metrics_gauge_set(jw_metrics_t *metric, int32_t value) {
+    atomic_store_explicit(&metric->gauge, value, memory_order_relaxed);
+}
+
+static inline void jw_metrics_gauge_add(jw_metrics_t *metric, int32_t delta) {
+    atomic_fetch_add_explicit(&metric->gauge, delta, memory_order_relaxed);
+}
+
+/** @brief Start of a timed section, for jw_metrics_observe_since */
+static inline int64_t jw_metrics_start(void) {
+    return esp_timer_get_time();
+}
+
+static inline void jw_metrics_observe_since(jw_metrics_t *metric, int64_t start) {
+    jw_metrics_observe(metric, (uint32_t)(esp_timer_get_time() - start));
+}
+
+#endif // JW_METRICS_H
\ No newline at end of file
@@ -26,6 +26,9 @@ struct jw_peers_context {
     TaskHandle_t logging_task;
     uint8_t blacklist[JW_PEERS_BLACKLIST_MAX_SIZE][ESP_NOW_ETH_ALEN];
     uint8_t blacklist_count;
+    uint32_t generation;           // Bumped under the mutex by every change of peers, read without it (one word)
+    uint32_t settings_generation;  // Same, but only for peers added and names or intervals edited, not sensor data
+    uint32_t blacklist_generation; // Same for the blacklist
 };
 
 static jw_peers_context_t *jw_peers_context = NULL;
@@ -48,6 +51,9 @@ esp_err_t jw_peers_initialize(void) {
 
     jw_peers_context->peers = NULL;
     jw_peers_context->peer_count = 0;
+    jw_peers_context->generation = 0;
+    jw_peers_context->settings_generation = 0;
+    jw_peers_context->blacklist_generation = 0;
     jw_peers_context->mutex = xSemaphoreCreateMutex();
     jw_peers_context->update_queue = xQueueCreate(JW_PEERS_UPDATE_QUEUE_SIZE, sizeof(jw_peer_data_t));
     if (!jw_peers_context->mutex || !jw_peers_context->update_queue) {
@@ -184,6 +190,8 @@ esp_err_t jw_peers_add_peer(const uint8_t *mac_address, jw_peer_type_t peer_type
     memset(&peer->latest_data, 0, sizeof(jw_peer_data_t));
     peer->data_interval_sec = (interval_sec > 0) ? interval_sec : 60;
     jw_peers_context->peer_count++;
+    jw_peers_context->generation++;
+    jw_peers_context->settings_generation++;
 
     save_to_nvs();
 
@@ -225,6 +233,7 @@ esp_err_t jw_peers_update_data(const uint8_t *mac_address, const jw_peer_data_t
             jw_peers_context->peers[i].latest_data = *data;
             jw_peers_context->peers[i].last_update = data->timestamp;
             jw_peers_context->peers[i].is_active = true;
+            jw_peers_context->generation++;
             if (xQueueSend(jw_peers_context->update_queue, data, pdMS_TO_TICKS(100)) != pdTRUE) {
                 ESP_LOGW(TAG, "Update queue full for " MACSTR, MAC2STR(mac_address));
             }
@@ -252,6 +261,8 @@ esp_err_t jw_peers_edit_name(const uint8_t *mac_address, const char *new_name) {
         if (memcmp(jw_peers_context->peers[i].mac_address, mac_address, ESP_NOW_ETH_ALEN) == 0) {
             strncpy(jw_peers_context->peers[i].peer_name, new_name, sizeof(jw_peers_context->peers[i].peer_name) - 1);
             jw_peers_context->peers[i].peer_name[sizeof(jw_peers_context->peers[i].peer_name) - 1] = '\0';
+            jw_peers_context->generation++;
+            jw_peers_context->settings_generation++;
             save_to_nvs();
             ESP_LOGI(TAG, "Edited name for " MACSTR " to %s", MAC2STR(mac_address), new_name);
             xSemaphoreGive(jw_peers_context->mutex);
@@ -276,6 +287,8 @@ esp_err_t jw_peers_edit_interval(const uint8_t *mac_address, uint8_t interval_se
     for (uint8_t i = 0; i < jw_peers_context->peer_count; i++) {
         if (memcmp(jw_peers_context->peers[i].mac_address, mac_address, ESP_NOW_ETH_ALEN) == 0) {
             jw_peers_context->peers[i].data_interval_sec = interval_sec;
+            jw_peers_context->generation++;
+            jw_peers_context->settings_generation++;
             save_to_nvs();
             ESP_LOGI(TAG, "Edited interval for " MACSTR " to %d sec", MAC2STR(mac_address), interval_sec);
             xSemaphoreGive(jw_peers_context->mutex);
@@ -287,6 +300,47 @@ esp_err_t jw_peers_edit_interval(const uint8_t *mac_address, uint8_t interval_se
     return ESP_ERR_NOT_FOUND;
 }
 
+esp_err_t jw_peers_edit_batch(const jw_peer_edit_t *edits, uint8_t count) {
+    if (!jw_peers_context || (!edits && count) || count > JW_PEERS_MAX_CAPACITY) {
+        ESP_LOGE(TAG, "Invalid parameters or not initialized");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (xSemaphoreTake(jw_peers_context->mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed to take mutex");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    jw_peer_entry_t *targets[JW_PEERS_MAX_CAPACITY];
+    for (uint8_t e = 0; e < count; e++) {
+        targets[e] = NULL;
+        for (uint8_t i = 0; i < jw_peers_context->peer_count; i++) {
+            if (memcmp(jw_peers_context->peers[i].mac_address, edits[e].mac_address, ESP_NOW_ETH_ALEN) == 0) {
+                targets[e] = &jw_peers_context->peers[i];
+                break;
+            }
+        }
+        if (!targets[e]) {
+            ESP_LOGW(TAG, "Peer " MACSTR " not found for batch edit", MAC2STR(edits[e].mac_address));
+            xSemaphoreGive(jw_peers_context->mutex);
+            return ESP_ERR_NOT_FOUND; // Checked before anything changes
+        }
+    }
+
+    for (uint8_t e = 0; e < count; e++) {
+        strncpy(targets[e]->peer_name, edits[e].peer_name, sizeof(targets[e]->peer_name) - 1);
+        targets[e]->peer_name[sizeof(targets[e]->peer_name) - 1] = '\0';
+        targets[e]->data_interval_sec = edits[e].data_interval_sec;
+    }
+    if (count) {
+        jw_peers_context->generation++;
+        jw_peers_context->settings_generation++;
+        save_to_nvs();
+    }
+    ESP_LOGI(TAG, "Edited %d peers", count);
+    xSemaphoreGive(jw_peers_context->mutex);
+    return ESP_OK;
+}
+
 esp_err_t jw_peers_add_to_blacklist(const uint8_t *mac_address) {
     if (!jw_peers_context || !mac_address) {
         ESP_LOGE(TAG, "Invalid parameters or not initialized");
@@ -314,6 +368,7 @@ esp_err_t jw_peers_add_to_blacklist(const uint8_t *mac_address) {
 
     memcpy(jw_peers_context->blacklist[jw_peers_context->blacklist_count], mac_address, ESP_NOW_ETH_ALEN);
     jw_peers_context->blacklist_count++;
+    jw_peers_context->blacklist_generation++;
     save_blacklist_to_nvs();
     ESP_LOGI(TAG, "Added " MACSTR " to blacklist", MAC2STR(mac_address));
     xSemaphoreGive(jw_peers_context->mutex);
@@ -338,6 +393,7 @@ esp_err_t jw_peers_remove_from_blacklist(const uint8_t *mac_address) {
             }
             memset(jw_peers_context->blacklist[jw_peers_context->blacklist_count - 1], 0, ESP_NOW_ETH_ALEN);
             jw_peers_context->blacklist_count--;
+            jw_peers_context->blacklist_generation++;
             save_blacklist_to_nvs();
             ESP_LOGI(TAG, "Removed " MACSTR " from blacklist", MAC2STR(mac_address));
             xSemaphoreGive(jw_peers_context->mutex);
@@ -385,6 +441,18 @@ bool jw_peers_is_blacklisted(const uint8_t *mac_address) {
     return false;
 }
 
+uint32_t jw_peers_get_generation(void) {
+    return jw_peers_context ? jw_peers_context->generation : 0;
+}
+
+uint32_t jw_peers_get_settings_generation(void) {
+    return jw_peers_context ? jw_peers_context->settings_generation : 0;
+}
+
+uint32_t jw_peers_get_blacklist_generation(void) {
+    return jw_peers_context ? jw_peers_context->blacklist_generation : 0;
+}
+
 static void jw_peers_run_logging_task(void *params) {
     jw_peer_data_t data_buffer[JW_PEERS_LOG_BUFFER_SIZE];
     uint8_t buffer_count = 0;
@@ -42,6 +42,13 @@ typedef struct {
     uint8_t data_interval_sec;
 } jw_peer_entry_t;
 
+/** One peer's settings for jw_peers_edit_batch, the full new values rather than a difference */
+typedef struct {
+    uint8_t mac_address[ESP_NOW_ETH_ALEN];
+    char peer_name[16];
+    uint8_t data_interval_sec;
+} jw_peer_edit_t;
+
 typedef struct jw_peers_context jw_peers_context_t;
 
 esp_err_t jw_peers_initialize(void);
@@ -51,11 +58,15 @@ esp_err_t jw_peers_get_peer(jw_peer_entry_t **peers, uint8_t *peer_count);
 esp_err_t jw_peers_update_data(const uint8_t *mac_address, const jw_peer_data_t *data);
 esp_err_t jw_peers_edit_name(const uint8_t *mac_address, const char *new_name);
 esp_err_t jw_peers_edit_interval(const uint8_t *mac_address, uint8_t interval_sec);
+esp_err_t jw_peers_edit_batch(const jw_peer_edit_t *edits, uint8_t count); // All or nothing, saved to NVS once
+uint32_t jw_peers_get_generation(void); // Changes with every change of the table, sensor data included (ETags)
+uint32_t jw_peers_get_settings_generation(void); // Changes with peers added and names or intervals edited only
 
 // Blacklist management
 esp_err_t jw_peers_add_to_blacklist(const uint8_t *mac_address);
 esp_err_t jw_peers_remove_from_blacklist(const uint8_t *mac_address);
 esp_err_t jw_peers_get_blacklist(uint8_t(*blacklist)[ESP_NOW_ETH_ALEN], uint8_t *blacklist_count);
 bool jw_peers_is_blacklisted(const uint8_t *mac_address);
+uint32_t jw_peers_get_blacklist_generation(void);
 
 #endif // JW_PEERS_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "jw_rtc.h"
+#include <string.h>
 #include "esp_sntp.h"
 #include "esp_log.h"
 
@@ -6,6 +7,7 @@ static const char *TAG = "JW_RTC";
 
 struct tm jw_rtc_time;
 jw_rtc_settings_t jw_rtc_settings = { .timezone = "EST5EDT" };
+static uint32_t jw_rtc_settings_generation = 0;
 
 // Callback for time sync notification
 static void time_sync_notification_cb(struct timeval *tv) {
@@ -52,3 +54,32 @@ uint32_t jw_rtc_get_time_sec(void) {
     time(&now);
     return (uint32_t)now;
 }
+
+/**
+ * @brief Change the timezone
+ * @param timezone POSIX TZ string
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on failure
+ *
+ * Updates jw_rtc_settings and the TZ environment used by localtime.
+ */
+esp_err_t jw_rtc_set_timezone(const char *timezone) {
+    if (!timezone || !timezone[0] || strlen(timezone) >= sizeof(jw_rtc_settings.timezone)) {
+        ESP_LOGE(TAG, "Invalid timezone");
+        return ESP_ERR_INVALID_ARG;
+    }
+    strcpy(jw_rtc_settings.timezone, timezone);
+    jw_rtc_settings_generation++;
+    setenv("TZ", jw_rtc_settings.timezone, 1);
+    tzset();
+    time_t now = time(NULL);
+    localtime_r(&now, &jw_rtc_time); // Same instant, new zone
+    return ESP_OK;
+}
+
+/**
+ * @brief Get the settings generation
+ * @return Counter incremented by every change of jw_rtc_settings
+ */
+uint32_t jw_rtc_get_generation(void) {
+    return jw_rtc_settings_generation;
+}
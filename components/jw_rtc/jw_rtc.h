@@ -33,4 +33,21 @@ esp_err_t jw_rtc_init(void);
  */
 uint32_t jw_rtc_get_time_sec(void);
 
+/**
+ * @brief Change the timezone
+ * @param timezone POSIX TZ string (e.g., "CET-1CEST,M3.5.0,M10.5.0/3")
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if it is empty or too long
+ *
+ * Takes effect for localtime immediately, nothing is persisted.
+ */
+esp_err_t jw_rtc_set_timezone(const char *timezone);
+
+/**
+ * @brief Get the settings generation
+ * @return uint32_t Counter incremented by every change of jw_rtc_settings
+ *
+ * Equal values mean unchanged settings since boot, e.g. for an HTTP ETag.
+ */
+uint32_t jw_rtc_get_generation(void);
+
 #endif // JW_RTC_H
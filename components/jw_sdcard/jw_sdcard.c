@@ -10,6 +10,7 @@
 #include <driver/sdmmc_host.h>
 #include <esp_vfs_fat.h>
 #include <esp_log.h>
+#include "jw_metrics.h"
 
 /** @brief Logging tag for SD card module */
 static const char *TAG = "JW_SDCARD";
@@ -24,6 +25,12 @@ static sdmmc_card_t *card = NULL;
 /** @brief Flag indicating SD card mount status */
 static bool is_mounted = false;
 
+/** @brief Write latency and failed writes, registered by jw_sdcard_init */
+static JW_METRICS_HISTOGRAM_DEFINE(write_seconds, "jw_sdcard_write_seconds", NULL, "SD card file append latency");
+static JW_METRICS_COUNTER_DEFINE(write_errors, "jw_sdcard_write_errors_total", NULL, "SD card writes that failed");
+
+static esp_err_t write_file(const char *path, const char *data);
+
 /**
  * @brief Initialize the SD card module
  * @return esp_err_t ESP_OK on success, ESP_FAIL on failure
@@ -39,6 +46,9 @@ esp_err_t jw_sdcard_init(void) {
         .allocation_unit_size = 16 * 1024
     };
 
+    jw_metrics_register(&write_seconds);
+    jw_metrics_register(&write_errors);
+
     ESP_LOGI(TAG, "Initializing SD card");
 
     slot_config.width = 4;
@@ -84,6 +94,20 @@ bool jw_sdcard_is_mounted(void) {
  * Writes data to the specified file, creating directories as needed.
  */
 esp_err_t jw_sdcard_write_file(const char *path, const char *data) {
+    int64_t start = jw_metrics_start();
+    esp_err_t err = write_file(path, data);
+    jw_metrics_observe_since(&write_seconds, start);
+    if (err != ESP_OK) jw_metrics_inc(&write_errors);
+    return err;
+}
+
+/**
+ * @brief Append data to a file, creating its directories first
+ * @param path Full path to the file
+ * @param data Data to write
+ * @return esp_err_t ESP_OK on success, ESP_FAIL on failure
+ */
+static esp_err_t write_file(const char *path, const char *data) {
     if (!is_mounted) {
         ESP_LOGW(TAG, "SD card not mounted, cannot write");
         return ESP_FAIL;
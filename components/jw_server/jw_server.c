@@ -5,6 +5,7 @@ static httpd_handle_t server = NULL;
 
 void jw_server_init(void) {
     jw_server_core_init(&server); // Pass server handle to core
+    jw_server_config_load();      // Saved Wi-Fi and timezone, jw_wifi_start applies them
     jw_log_msg("jw_server initialized");
 }
 
@@ -12,6 +13,7 @@ void jw_server_start(void) {
     if (server) {
         jw_server_http_start(server); // Start HTTP
         jw_server_ws_start(server);   // Start WebSocket
+        jw_server_config_start(server); // Settings API
         jw_log_msg("jw_server started");
     }
 }
@@ -28,4 +30,8 @@ void jw_server_stop(void) {
 
 void jw_server_send_peers_update(void) {
     jw_server_ws_send_peers_update(); // Delegate to WS module
+}
+
+esp_err_t jw_server_publish(const char* topic, const char* key, cJSON* json) {
+    return jw_server_ws_publish(topic, key, json); // Delegate to WS module
 }
\ No newline at end of file
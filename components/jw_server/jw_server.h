@@ -1,21 +1,71 @@
 #ifndef JW_SERVER_H
 #define JW_SERVER_H
 
+#include <sys/stat.h>
 #include "esp_http_server.h"
 #include "cJSON.h"
+#include "cJSON_Sax.h"
 
 // Public Interface (jw_server.c)
 void jw_server_init(void);           // Initialize the server component
 void jw_server_start(void);          // Start HTTP and WebSocket services
 void jw_server_stop(void);           // Stop all services
 void jw_server_send_peers_update(void); // Trigger Peer info update via WS
+esp_err_t jw_server_publish(const char* topic, const char* key, cJSON* json); // Queue json for the WS clients subscribed to topic
+                                                                              // ("peers", "telemetry/<mac>", "logs"), takes ownership.
+                                                                              // key: latest value wins among queued messages (peer MAC), NULL: event
 
 // Internal (for jw_server_* modules, not called directly by main.c)
+#ifndef JW_SERVER_CORE_WORKERS
+#define JW_SERVER_CORE_WORKERS 2        // Tasks running the handlers registered with jw_server_core_register_slow
+#endif
+#ifndef JW_SERVER_CORE_WORK_QUEUE
+#define JW_SERVER_CORE_WORK_QUEUE 8     // Detached requests waiting for a worker, more are answered 503
+#endif
+#ifndef JW_SERVER_CORE_WORKER_PRIORITY
+#define JW_SERVER_CORE_WORKER_PRIORITY 4 // Below the server task (5), which keeps serving WS and API while files stream
+#endif
+#ifndef JW_SERVER_CORE_WORKER_STACK
+#define JW_SERVER_CORE_WORKER_STACK 6144
+#endif
 void jw_server_core_init(httpd_handle_t* server);
+esp_err_t jw_server_core_register_slow(httpd_handle_t server, const httpd_uri_t* uri); // uri->handler runs on a worker with an async copy of the request
+#define JW_SERVER_CORE_ETAG_LEN 64 // W/"<boot>-<generation>-..." for a handful of generations
+void jw_server_core_etag(char* etag, size_t size, const uint32_t* generations, size_t count); // ETag of a state given by module generations
+bool jw_server_core_not_modified(httpd_req_t* req, const char* etag); // Sets ETag, true: If-None-Match matched and the 304 is sent
 void jw_server_core_parse_json(const char* data, cJSON** json);
+esp_err_t jw_server_core_stream_json(httpd_req_t* req, cJSON_SaxParser* parser); // Feeds the request body chunk by chunk.
+                                                                                // ESP_FAIL: receive failed, ESP_ERR_INVALID_ARG: not JSON
+esp_err_t jw_server_core_recv_json(httpd_req_t* req, cJSON** json); // Request body as a tree, built while it streams in, never held whole
+void jw_server_core_parse_json_arena(const char* data, size_t len, cJSON_Arena* arena, cJSON** json); // Resets arena, tree lives in it.
+                                                                                                     // NULL: not JSON or arena too small
+esp_err_t jw_server_core_send_json_chunked(httpd_req_t* req, const cJSON* json); // Chunked HTTP response, bounded RAM
+char* jw_server_core_print_json(const cJSON* json, size_t* len); // Unformatted copy in SPIRAM, heap_caps_free it, NULL on failure
+esp_err_t jw_server_core_send_ws_text(httpd_handle_t server, int fd, const char* text, size_t len); // Single WS text frame
+uint8_t* jw_server_core_encode_cbor(const cJSON* json, size_t* len); // CBOR copy in SPIRAM, heap_caps_free it, NULL on failure
+esp_err_t jw_server_core_send_ws_binary(httpd_handle_t server, int fd, const uint8_t* data, size_t len); // Single WS binary frame
+typedef struct jw_server_cache_entry jw_server_cache_entry_t; // SPIRAM LRU cache of SD files (jw_server_cache.c)
+void jw_server_cache_init(void);
+jw_server_cache_entry_t* jw_server_cache_get(const char* path, const struct stat* st); // Hit, or loaded if small enough, keyed by path + mtime + size. NULL: read the card
+const uint8_t* jw_server_cache_data(const jw_server_cache_entry_t* entry, size_t* size);
+void jw_server_cache_release(jw_server_cache_entry_t* entry); // Every non NULL get
+void jw_server_cache_clear(void);
+void jw_server_cache_stats(uint32_t* hits, uint32_t* misses, size_t* bytes);
+typedef struct jw_server_gzip jw_server_gzip_t; // Streaming gzip of a chunked response (jw_server_gzip.c)
+void jw_server_gzip_init(void);
+jw_server_gzip_t* jw_server_gzip_begin(httpd_req_t* req); // Before the first chunk. NULL: send plain, the client doesn't take gzip
+                                                          // or every compressor is busy
+esp_err_t jw_server_gzip_send_chunk(httpd_req_t* req, jw_server_gzip_t* gzip, const char* data, size_t len); // httpd_resp_send_chunk
+                                                          // through gzip, or plain for NULL. len 0 ends the response and frees gzip
+void jw_server_gzip_abort(jw_server_gzip_t* gzip); // Frees gzip without sending anything, for a response that failed
 void jw_server_http_start(httpd_handle_t server);
+void jw_server_config_load(void); // Applies the settings saved by PUT /api/config, before jw_wifi_start
+void jw_server_config_start(httpd_handle_t server); // GET/PUT /api/config (jw_server_config.c)
 void jw_server_http_stop(void);
 void jw_server_ws_start(httpd_handle_t server);
 void jw_server_ws_stop(void);
+void jw_server_ws_send_peers_update(void);
+esp_err_t jw_server_ws_publish(const char* topic, const char* key, cJSON* json);
+void jw_server_ws_client_closed(int fd); // Session close callback
 
 #endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef JW_SERVER_ASSETS_H
+#define JW_SERVER_ASSETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Files of html/, gzipped at build time and embedded in flash (table generated by jw_server_assets.py)
+typedef struct {
+    const char* uri;           // "/main.css", percent-encoded
+    const char* type;          // Content-Type
+    const char* encoding;      // Content-Encoding, "gzip" or NULL if compression didn't pay off
+    const char* cache_control; // Cache-Control
+    const char* etag;          // Strong ETag of the body, quoted
+    const uint8_t* start;      // Body as sent
+    const uint8_t* end;
+} jw_server_asset_t;
+
+extern const jw_server_asset_t jw_server_assets[];
+extern const size_t jw_server_asset_count;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+# Build step of jw_server: minifies and gzips the files in html/ and writes the asset manifest.
+# Usage: jw_server_assets.py <output dir> <file>...
+# For every file <name> it writes <output dir>/<C identifier of name>.asset, which CMakeLists.txt embeds with
+# target_add_binary_data, plus <output dir>/jw_server_assets.c with the jw_server_assets[] table.
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+import urllib.parse
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+    ".svg": "image/svg+xml",
+}
+
+# Pages aren't fingerprinted, so they are revalidated (cheap with the ETag), everything else is cached for a week
+CACHE_PAGE = "no-cache"
+CACHE_STATIC = "public, max-age=604800"
+
+
+def c_identifier(name):
+    # Same result as CMake's string(MAKE_C_IDENTIFIER)
+    identifier = re.sub(r"[^A-Za-z0-9_]", "_", name)
+    return "_" + identifier if identifier[0].isdigit() else identifier
+
+
+def minify(name, data):
+    # Whitespace only: leading/trailing blanks and empty lines go, line breaks stay so JS semicolon insertion is unaffected
+    if os.path.splitext(name)[1].lower() not in (".html", ".css", ".js"):
+        return data
+    lines = data.decode("utf-8").splitlines()
+    if lines and max(len(line) for line in lines) > 1000:
+        return data  # Already minified
+    return ("\n".join(line.strip() for line in lines if line.strip()) + "\n").encode("utf-8")
+
+
+def main():
+    out_dir = sys.argv[1]
+    os.makedirs(out_dir, exist_ok=True)
+    externs = []
+    entries = []
+    for path in sorted(sys.argv[2:]):
+        name = os.path.basename(path)
+        ident = c_identifier(name)
+        with open(path, "rb") as f:
+            raw = f.read()
+        body = minify(name, raw)
+        encoding = "NULL"
+        compressed = gzip.compress(body, compresslevel=9, mtime=0)  # mtime=0 keeps the output and ETag reproducible
+        if len(compressed) < len(body):  # Already compressed formats (favicon.ico) are stored as they are
+            body = compressed
+            encoding = '"gzip"'
+        with open(os.path.join(out_dir, ident + ".asset"), "wb") as f:
+            f.write(body)
+        mime = MIME_TYPES.get(os.path.splitext(name)[1].lower(), "application/octet-stream")
+        cache = CACHE_PAGE if mime == "text/html" else CACHE_STATIC
+        etag = '\\"' + hashlib.sha256(body).hexdigest()[:16] + '\\"'
+        uri = "/" + urllib.parse.quote(name)
+        externs.append('extern const uint8_t %s_start[] asm("_binary_%s_asset_start");' % (ident, ident))
+        externs.append('extern const uint8_t %s_end[] asm("_binary_%s_asset_end");' % (ident, ident))
+        entries.append('    { "%s", "%s", %s, "%s", "%s", %s_start, %s_end }, // %d -> %d bytes'
+                       % (uri, mime, encoding, cache, etag, ident, ident, len(raw), len(body)))
+    source = "\n".join([
+        "// Generated by jw_server_assets.py from components/jw_server/html, do not edit",
+        '#include "jw_server_assets.h"',
+        "",
+    ] + externs + [
+        "",
+        "const jw_server_asset_t jw_server_assets[] = {",
+    ] + entries + [
+        "};",
+        "const size_t jw_server_asset_count = sizeof(jw_server_assets) / sizeof(jw_server_assets[0]);",
+        "",
+    ])
+    with open(os.path.join(out_dir, "jw_server_assets.c"), "w") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,158 @@
+#include "jw_server.h"
+#include "jw_log.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/unistd.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define JW_SERVER_CACHE_BUDGET (512 * 1024) // SPIRAM bytes for file contents, least recently used files go first
+#define JW_SERVER_CACHE_MAX_FILE (64 * 1024) // Bigger files (daily logs) are streamed from the card instead
+
+struct jw_server_cache_entry {
+    struct jw_server_cache_entry* prev; // LRU list, head is the most recently used
+    struct jw_server_cache_entry* next;
+    int refs;                           // Callers holding it, plus one while it's in the list
+    time_t mtime;
+    size_t size;
+    uint8_t* data;
+    char path[];                        // Followed by the contents, same allocation
+};
+
+static SemaphoreHandle_t cache_lock = NULL;
+static jw_server_cache_entry_t* cache_head = NULL;
+static jw_server_cache_entry_t* cache_tail = NULL;
+static size_t cache_bytes = 0;
+static uint32_t cache_hits = 0;
+static uint32_t cache_misses = 0;
+
+static void cache_unlink(jw_server_cache_entry_t* entry) {
+    if (entry->prev) entry->prev->next = entry->next;
+    else cache_head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev;
+    else cache_tail = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+static void cache_push_front(jw_server_cache_entry_t* entry) {
+    entry->prev = NULL;
+    entry->next = cache_head;
+    if (cache_head) cache_head->prev = entry;
+    cache_head = entry;
+    if (!cache_tail) cache_tail = entry;
+}
+
+static void cache_unref(jw_server_cache_entry_t* entry) {
+    if (--entry->refs == 0) heap_caps_free(entry);
+}
+
+// Takes the entry out of the list, it's freed once the last caller releases it. Lock held
+static void cache_drop(jw_server_cache_entry_t* entry) {
+    cache_unlink(entry);
+    cache_bytes -= entry->size;
+    cache_unref(entry);
+}
+
+static jw_server_cache_entry_t* cache_find(const char* path) {
+    for (jw_server_cache_entry_t* entry = cache_head; entry; entry = entry->next) {
+        if (strcmp(entry->path, path) == 0) return entry;
+    }
+    return NULL;
+}
+
+// Whole file into a fresh entry, NULL if it changed size while reading or the SPIRAM is short
+static jw_server_cache_entry_t* cache_load(const char* path, const struct stat* st) {
+    size_t path_len = strlen(path) + 1;
+    jw_server_cache_entry_t* entry = heap_caps_malloc(sizeof(jw_server_cache_entry_t) + path_len + st->st_size, MALLOC_CAP_SPIRAM);
+    if (!entry) return NULL;
+    memset(entry, 0, sizeof(jw_server_cache_entry_t));
+    memcpy(entry->path, path, path_len);
+    entry->data = (uint8_t*)entry->path + path_len;
+    entry->size = st->st_size;
+    entry->mtime = st->st_mtime;
+    entry->refs = 1;
+    int fd = open(path, O_RDONLY);
+    size_t done = 0;
+    while (fd >= 0 && done < entry->size) {
+        ssize_t n = read(fd, entry->data + done, entry->size - done);
+        if (n <= 0) break;
+        done += n;
+    }
+    if (fd >= 0) close(fd);
+    if (done != entry->size) {
+        heap_caps_free(entry);
+        return NULL;
+    }
+    return entry;
+}
+
+void jw_server_cache_init(void) {
+    if (!cache_lock) cache_lock = xSemaphoreCreateMutex();
+}
+
+jw_server_cache_entry_t* jw_server_cache_get(const char* path, const struct stat* st) {
+    if (!cache_lock) return NULL;
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    jw_server_cache_entry_t* entry = cache_find(path);
+    if (entry && (entry->mtime != st->st_mtime || entry->size != (size_t)st->st_size)) {
+        cache_drop(entry); // Rewritten or appended to since it was cached
+        entry = NULL;
+    }
+    if (entry) {
+        cache_hits++;
+        cache_unlink(entry);
+        cache_push_front(entry);
+        entry->refs++;
+        xSemaphoreGive(cache_lock);
+        return entry;
+    }
+    cache_misses++;
+    xSemaphoreGive(cache_lock);
+    if (st->st_size > JW_SERVER_CACHE_MAX_FILE) return NULL;
+
+    entry = cache_load(path, st); // Card read without the lock, hits on other files carry on
+    if (!entry) return NULL;
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    jw_server_cache_entry_t* other = cache_find(path);
+    if (other) cache_drop(other); // Loaded concurrently, the newer read wins
+    while (cache_tail && cache_bytes + entry->size > JW_SERVER_CACHE_BUDGET) cache_drop(cache_tail);
+    cache_push_front(entry);
+    cache_bytes += entry->size;
+    entry->refs++;
+    xSemaphoreGive(cache_lock);
+    return entry;
+}
+
+const uint8_t* jw_server_cache_data(const jw_server_cache_entry_t* entry, size_t* size) {
+    *size = entry->size;
+    return entry->data;
+}
+
+void jw_server_cache_release(jw_server_cache_entry_t* entry) {
+    if (!entry) return;
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    cache_unref(entry);
+    xSemaphoreGive(cache_lock);
+}
+
+void jw_server_cache_clear(void) {
+    if (!cache_lock) return;
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    while (cache_head) cache_drop(cache_head);
+    xSemaphoreGive(cache_lock);
+}
+
+void jw_server_cache_stats(uint32_t* hits, uint32_t* misses, size_t* bytes) {
+    if (!cache_lock) {
+        *hits = *misses = 0;
+        *bytes = 0;
+        return;
+    }
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    *hits = cache_hits;
+    *misses = cache_misses;
+    *bytes = cache_bytes;
+    xSemaphoreGive(cache_lock);
+}
\ No newline at end of file
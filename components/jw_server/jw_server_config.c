@@ -0,0 +1,338 @@
+#include "jw_server.h"
+#include "jw_wifi.h"
+#include "jw_rtc.h"
+#include "jw_peers.h"
+#include "jw_log.h"
+#include "cJSON_Bind.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include <string.h>
+
+#define JW_SERVER_CONFIG_NVS "jw_config"          // Every /api/config key in one namespace, written with one commit
+#define JW_SERVER_CONFIG_NVS_MODE "wifi_mode"     // Credentials and channel use the JW_WIFI_NVS_KEY_* names
+#define JW_SERVER_CONFIG_NVS_TIMEZONE "timezone"
+#define JW_SERVER_CONFIG_MAX_BODY 2048
+#define JW_SERVER_CONFIG_APPLY_US 500000          // Radio restarts once the response had time to leave
+
+// The whole settings document, a PUT is decoded over a copy of the current one so absent keys keep their value
+typedef struct {
+    char mode[8]; // "off", "sta", "ap", "apsta"
+    uint8_t channel;
+    jw_wifi_ap_settings_t ap;
+    jw_wifi_sta_settings_t sta;
+} config_wifi_t;
+
+typedef struct {
+    config_wifi_t wifi;
+    char timezone[sizeof(jw_rtc_settings.timezone)];
+} config_t;
+
+// {"mac":"aa:bb:cc:dd:ee:ff","name":"Porch","interval":10}, name and interval default to the current values
+typedef struct {
+    char mac[18];
+    char name[16];
+    uint8_t interval;
+} config_peer_t;
+
+static const cJSON_BindField config_ap_fields[] = {
+    CJSON_BIND_STRING(jw_wifi_ap_settings_t, ssid, "ssid", 0),
+    CJSON_BIND_STRING(jw_wifi_ap_settings_t, pass, "pass", 0),
+};
+
+static const cJSON_BindField config_sta_fields[] = {
+    CJSON_BIND_STRING(jw_wifi_sta_settings_t, ssid, "ssid", 0),
+    CJSON_BIND_STRING(jw_wifi_sta_settings_t, pass, "pass", 0),
+};
+
+static const cJSON_BindField config_wifi_fields[] = {
+    CJSON_BIND_STRING(config_wifi_t, mode, "mode", 0),
+    CJSON_BIND_UINT(config_wifi_t, channel, "channel", 0, 1, 13),
+    CJSON_BIND_OBJECT(config_wifi_t, ap, "ap", 0, config_ap_fields),
+    CJSON_BIND_OBJECT(config_wifi_t, sta, "sta", 0, config_sta_fields),
+};
+
+static const cJSON_BindField config_fields[] = {
+    CJSON_BIND_OBJECT(config_t, wifi, "wifi", 0, config_wifi_fields),
+    CJSON_BIND_STRING(config_t, timezone, "timezone", 0),
+};
+
+static const cJSON_BindField config_peer_fields[] = {
+    CJSON_BIND_STRING(config_peer_t, mac, "mac", cJSON_BindRequired),
+    CJSON_BIND_STRING(config_peer_t, name, "name", 0),
+    CJSON_BIND_UINT(config_peer_t, interval, "interval", 0, 1, 255),
+};
+
+static const char* config_modes[] = { "off", "sta", "ap", "apsta" }; // jw_wifi_user_mode_t order
+
+static esp_timer_handle_t config_apply_timer = NULL;
+
+static int config_mode_parse(const char* mode) {
+    for (int i = 0; i < (int)(sizeof(config_modes) / sizeof(config_modes[0])); i++) {
+        if (strcmp(config_modes[i], mode) == 0) return i;
+    }
+    return -1;
+}
+
+static void config_current(config_t* config) {
+    const jw_wifi_settings_t* wifi = jw_wifi_get_settings();
+    memset(config, 0, sizeof(*config));
+    strlcpy(config->wifi.mode, wifi->mode <= JW_WIFI_MODE_APSTA ? config_modes[wifi->mode] : "", sizeof(config->wifi.mode));
+    config->wifi.channel = wifi->channel;
+    strlcpy(config->wifi.ap.ssid, wifi->ap.ssid, sizeof(config->wifi.ap.ssid));
+    strlcpy(config->wifi.ap.pass, wifi->ap.pass, sizeof(config->wifi.ap.pass));
+    strlcpy(config->wifi.sta.ssid, wifi->sta.ssid, sizeof(config->wifi.sta.ssid));
+    strlcpy(config->wifi.sta.pass, wifi->sta.pass, sizeof(config->wifi.sta.pass));
+    strlcpy(config->timezone, jw_rtc_settings.timezone, sizeof(config->timezone));
+}
+
+// NULL when the settings can be applied, otherwise what is wrong with them
+static const char* config_validate(const config_t* config) {
+    int mode = config_mode_parse(config->wifi.mode);
+    if (mode < 0) return "wifi.mode: off, sta, ap or apsta";
+    if (config->wifi.channel < 1 || config->wifi.channel > 13) return "wifi.channel: 1 to 13";
+    bool ap = mode == JW_WIFI_MODE_AP || mode == JW_WIFI_MODE_APSTA; // Each interface's settings only matter while it runs
+    bool sta = mode == JW_WIFI_MODE_STA || mode == JW_WIFI_MODE_APSTA;
+    if (ap && !config->wifi.ap.ssid[0]) return "wifi.ap.ssid: empty";
+    if (ap && strlen(config->wifi.ap.pass) < 8) return "wifi.ap.pass: WPA2 needs 8 to 63 characters";
+    if (sta && !config->wifi.sta.ssid[0]) return "wifi.sta.ssid: empty";
+    if (config->wifi.sta.pass[0] && strlen(config->wifi.sta.pass) < 8) return "wifi.sta.pass: WPA2 needs 8 to 63 characters";
+    if (!config->timezone[0]) return "timezone: empty";
+    return NULL;
+}
+
+static bool config_wifi_equal(const config_wifi_t* a, const config_wifi_t* b) {
+    return strcmp(a->mode, b->mode) == 0 && a->channel == b->channel &&
+           strcmp(a->ap.ssid, b->ap.ssid) == 0 && strcmp(a->ap.pass, b->ap.pass) == 0 &&
+           strcmp(a->sta.ssid, b->sta.ssid) == 0 && strcmp(a->sta.pass, b->sta.pass) == 0;
+}
+
+static void config_apply_wifi(const config_wifi_t* wifi) {
+    jw_wifi_settings_t settings = *jw_wifi_get_settings(); // Country code isn't part of the document
+    settings.mode = (jw_wifi_user_mode_t)config_mode_parse(wifi->mode);
+    settings.channel = wifi->channel;
+    settings.ap = wifi->ap;
+    strlcpy(settings.sta.ssid, wifi->sta.ssid, sizeof(settings.sta.ssid));
+    strlcpy(settings.sta.pass, wifi->sta.pass, sizeof(settings.sta.pass));
+    jw_wifi_set_settings(&settings);
+}
+
+static void config_apply_timer_cb(void* arg) {
+    if (jw_wifi_apply() != ESP_OK) jw_log_msg("Config: Wi-Fi apply failed");
+}
+
+// Only the keys that differ from what is stored are written, and all of them are committed together
+static esp_err_t config_save(const config_t* old, const config_t* config) {
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(JW_SERVER_CONFIG_NVS, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+    uint8_t mode = (uint8_t)config_mode_parse(config->wifi.mode);
+    if (strcmp(old->wifi.mode, config->wifi.mode) != 0) err = nvs_set_u8(nvs, JW_SERVER_CONFIG_NVS_MODE, mode);
+    if (err == ESP_OK && old->wifi.channel != config->wifi.channel) err = nvs_set_u8(nvs, JW_WIFI_NVS_KEY_CHANNEL, config->wifi.channel);
+    if (err == ESP_OK && strcmp(old->wifi.ap.ssid, config->wifi.ap.ssid) != 0) err = nvs_set_str(nvs, JW_WIFI_NVS_KEY_AP_SSID, config->wifi.ap.ssid);
+    if (err == ESP_OK && strcmp(old->wifi.ap.pass, config->wifi.ap.pass) != 0) err = nvs_set_str(nvs, JW_WIFI_NVS_KEY_AP_PASS, config->wifi.ap.pass);
+    if (err == ESP_OK && strcmp(old->wifi.sta.ssid, config->wifi.sta.ssid) != 0) err = nvs_set_str(nvs, JW_WIFI_NVS_KEY_STA_SSID, config->wifi.sta.ssid);
+    if (err == ESP_OK && strcmp(old->wifi.sta.pass, config->wifi.sta.pass) != 0) err = nvs_set_str(nvs, JW_WIFI_NVS_KEY_STA_PASS, config->wifi.sta.pass);
+    if (err == ESP_OK && strcmp(old->timezone, config->timezone) != 0) err = nvs_set_str(nvs, JW_SERVER_CONFIG_NVS_TIMEZONE, config->timezone);
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+    return err;
+}
+
+// Missing keys keep the value already in config
+static void config_read_str(nvs_handle_t nvs, const char* key, char* value, size_t size) {
+    char stored[64];
+    size_t len = sizeof(stored);
+    if (nvs_get_str(nvs, key, stored, &len) == ESP_OK && len <= size) memcpy(value, stored, len);
+}
+
+static cJSON* config_to_json(const config_t* config) {
+    cJSON* json = cJSON_CreateObject();
+    cJSON* wifi = cJSON_AddObjectToObject(json, "wifi");
+    cJSON_AddStringToObject(wifi, "mode", config->wifi.mode);
+    cJSON_AddNumberToObject(wifi, "channel", config->wifi.channel);
+    cJSON_AddStringToObject(cJSON_AddObjectToObject(wifi, "ap"), "ssid", config->wifi.ap.ssid); // Passwords are write only
+    cJSON_AddStringToObject(cJSON_AddObjectToObject(wifi, "sta"), "ssid", config->wifi.sta.ssid);
+    cJSON_AddStringToObject(json, "timezone", config->timezone);
+    cJSON* list = cJSON_AddArrayToObject(json, "peers");
+    jw_peer_entry_t* peers = NULL;
+    uint8_t peer_count = 0;
+    if (jw_peers_get_peer(&peers, &peer_count) != ESP_OK) return json;
+    for (uint8_t i = 0; i < peer_count; i++) {
+        char mac_str[18];
+        snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(peers[i].mac_address));
+        cJSON* peer = cJSON_CreateObject();
+        cJSON_AddStringToObject(peer, "mac", mac_str);
+        cJSON_AddStringToObject(peer, "name", peers[i].peer_name);
+        cJSON_AddNumberToObject(peer, "interval", peers[i].data_interval_sec);
+        cJSON_AddItemToArray(list, peer);
+    }
+    return json;
+}
+
+static const char* config_bind_error(cJSON_BindStatus status) {
+    switch (status) {
+        case cJSON_BindTypeMismatch: return "wrong type";
+        case cJSON_BindOutOfRange: return "out of range";
+        case cJSON_BindStringTooLong: return "too long";
+        case cJSON_BindMissingField: return "missing";
+        default: return "invalid";
+    }
+}
+
+// "peers" of a PUT, only entries that change something end up in edits. NULL or what is wrong with them, which may
+// be formatted into error
+static const char* config_parse_peers(const cJSON* list, jw_peer_edit_t* edits, uint8_t* edit_count, char* error, size_t error_size) {
+    const cJSON* item = NULL;
+    jw_peer_entry_t* peers = NULL;
+    uint8_t peer_count = 0;
+    *edit_count = 0;
+    if (!list) return NULL;
+    if (!cJSON_IsArray(list)) return "peers: wrong type";
+    if (cJSON_GetArraySize(list) > JW_PEERS_MAX_CAPACITY) return "peers: too long";
+    if (jw_peers_get_peer(&peers, &peer_count) != ESP_OK) return "peers: unavailable";
+    cJSON_ArrayForEach(item, list) {
+        config_peer_t peer = { 0 };
+        const char* field = NULL;
+        cJSON_BindStatus status = cJSON_BindDecodeItem(config_peer_fields, sizeof(config_peer_fields) / sizeof(config_peer_fields[0]), &peer, item, &field);
+        if (status != cJSON_BindOk) {
+            snprintf(error, error_size, "peers.%s: %s", field ? field : "item", config_bind_error(status));
+            return error;
+        }
+        jw_peer_edit_t* edit = &edits[*edit_count];
+        unsigned mac[6];
+        int end = 0;
+        if (sscanf(peer.mac, "%2x:%2x:%2x:%2x:%2x:%2x%n", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5], &end) != 6 || peer.mac[end]) {
+            return "peers.mac: invalid";
+        }
+        for (int i = 0; i < 6; i++) edit->mac_address[i] = mac[i];
+        const jw_peer_entry_t* current = NULL;
+        for (uint8_t i = 0; i < peer_count && !current; i++) {
+            if (memcmp(peers[i].mac_address, edit->mac_address, ESP_NOW_ETH_ALEN) == 0) current = &peers[i];
+        }
+        if (!current) return "peers.mac: unknown peer";
+        strlcpy(edit->peer_name, peer.name[0] ? peer.name : current->peer_name, sizeof(edit->peer_name));
+        edit->data_interval_sec = peer.interval ? peer.interval : current->data_interval_sec;
+        if (strcmp(edit->peer_name, current->peer_name) != 0 || edit->data_interval_sec != current->data_interval_sec) (*edit_count)++;
+    }
+    return NULL;
+}
+
+// Wi-Fi, timezone and peer names and intervals as of now. Sensor readings don't change the document, so the peer
+// settings generation is used rather than the table's
+static void config_etag(char* etag, size_t size) {
+    uint32_t generations[] = { jw_wifi_get_generation(), jw_rtc_get_generation(), jw_peers_get_settings_generation() };
+    jw_server_core_etag(etag, size, generations, sizeof(generations) / sizeof(generations[0]));
+}
+
+static esp_err_t config_send(httpd_req_t* req, const config_t* config) {
+    cJSON* json = config_to_json(config);
+    esp_err_t err = jw_server_core_send_json_chunked(req, json);
+    cJSON_Delete(json);
+    return err;
+}
+
+// GET /api/config: {"wifi":{"mode":"apsta","channel":1,"ap":{"ssid":".."},"sta":{"ssid":".."}},"timezone":"..","peers":[..]}
+static esp_err_t config_get_handler(httpd_req_t* req) {
+    char etag[JW_SERVER_CORE_ETAG_LEN];
+    config_etag(etag, sizeof(etag)); // Before reading, a change in between only costs the next poll a full response
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (jw_server_core_not_modified(req, etag)) return ESP_OK;
+    config_t config;
+    config_current(&config);
+    return config_send(req, &config);
+}
+
+// PUT /api/config: the same document, whole or any part of it, passwords as "pass". Nothing is changed unless all
+// of it is valid. Registered slow, the NVS write stalls flash access
+static esp_err_t config_put_handler(httpd_req_t* req) {
+    if (req->content_len == 0 || req->content_len > JW_SERVER_CONFIG_MAX_BODY) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body missing or too large");
+    }
+    cJSON* root = NULL;
+    if (jw_server_core_recv_json(req, &root) == ESP_FAIL) return ESP_FAIL; // Connection broke off, nothing to answer
+
+    config_t current;
+    config_t config;
+    config_current(&current);
+    config = current;
+    const char* error = NULL;
+    const char* field = NULL;
+    char message[64];
+    jw_peer_edit_t edits[JW_PEERS_MAX_CAPACITY];
+    uint8_t edit_count = 0;
+    cJSON_BindStatus status = root ? cJSON_BindDecodeItem(config_fields, sizeof(config_fields) / sizeof(config_fields[0]), &config, root, &field)
+                                   : cJSON_BindSyntaxError;
+    if (status == cJSON_BindSyntaxError || status == cJSON_BindNotAnObject) {
+        error = "Not a JSON object";
+    } else if (status != cJSON_BindOk) {
+        snprintf(message, sizeof(message), "%s: %s", field ? field : "config", config_bind_error(status));
+        error = message;
+    } else {
+        error = config_validate(&config);
+    }
+    if (!error) error = config_parse_peers(cJSON_GetObjectItemCaseSensitive(root, "peers"), edits, &edit_count, message, sizeof(message));
+    cJSON_Delete(root);
+    if (error) return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, error);
+
+    // Peers first: the only step that can still fail (a peer removed meanwhile), and it changes nothing if it does
+    if (edit_count) {
+        if (jw_peers_edit_batch(edits, edit_count) != ESP_OK) return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Peers changed meanwhile");
+        jw_server_ws_send_peers_update();
+    }
+    bool wifi_changed = !config_wifi_equal(&current.wifi, &config.wifi);
+    bool timezone_changed = strcmp(current.timezone, config.timezone) != 0;
+    if (wifi_changed) config_apply_wifi(&config.wifi);
+    if (timezone_changed) jw_rtc_set_timezone(config.timezone);
+    if ((wifi_changed || timezone_changed) && config_save(&current, &config) != ESP_OK) {
+        jw_log_msg("Config: NVS save failed"); // Applied until the next restart
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Applied but not saved");
+    }
+    char etag[JW_SERVER_CORE_ETAG_LEN];
+    config_etag(etag, sizeof(etag)); // The next GET can revalidate against the state just written
+    httpd_resp_set_hdr(req, "ETag", etag);
+    esp_err_t err = config_send(req, &config);
+    if (wifi_changed && config_apply_timer) {
+        esp_timer_stop(config_apply_timer); // A second PUT in quick succession restarts the radio once
+        esp_timer_start_once(config_apply_timer, JW_SERVER_CONFIG_APPLY_US);
+    }
+    return err;
+}
+
+void jw_server_config_load(void) {
+    nvs_handle_t nvs;
+    if (nvs_open(JW_SERVER_CONFIG_NVS, NVS_READONLY, &nvs) != ESP_OK) return; // Nothing saved yet
+    config_t current;
+    config_t config;
+    config_current(&current);
+    config = current;
+    uint8_t mode;
+    if (nvs_get_u8(nvs, JW_SERVER_CONFIG_NVS_MODE, &mode) == ESP_OK && mode <= JW_WIFI_MODE_APSTA) {
+        strlcpy(config.wifi.mode, config_modes[mode], sizeof(config.wifi.mode));
+    }
+    nvs_get_u8(nvs, JW_WIFI_NVS_KEY_CHANNEL, &config.wifi.channel);
+    config_read_str(nvs, JW_WIFI_NVS_KEY_AP_SSID, config.wifi.ap.ssid, sizeof(config.wifi.ap.ssid));
+    config_read_str(nvs, JW_WIFI_NVS_KEY_AP_PASS, config.wifi.ap.pass, sizeof(config.wifi.ap.pass));
+    config_read_str(nvs, JW_WIFI_NVS_KEY_STA_SSID, config.wifi.sta.ssid, sizeof(config.wifi.sta.ssid));
+    config_read_str(nvs, JW_WIFI_NVS_KEY_STA_PASS, config.wifi.sta.pass, sizeof(config.wifi.sta.pass));
+    config_read_str(nvs, JW_SERVER_CONFIG_NVS_TIMEZONE, config.timezone, sizeof(config.timezone));
+    nvs_close(nvs);
+    if (config_validate(&config)) {
+        jw_log_msg("Config: stored settings invalid, using defaults");
+        return;
+    }
+    if (!config_wifi_equal(&current.wifi, &config.wifi)) config_apply_wifi(&config.wifi); // jw_wifi_start applies it
+    if (strcmp(current.timezone, config.timezone) != 0) jw_rtc_set_timezone(config.timezone);
+    jw_log_msg("Config: stored settings loaded");
+}
+
+void jw_server_config_start(httpd_handle_t server) {
+    httpd_uri_t get = { .uri = "/api/config", .method = HTTP_GET, .handler = config_get_handler };
+    httpd_uri_t put = { .uri = "/api/config", .method = HTTP_PUT, .handler = config_put_handler };
+    httpd_register_uri_handler(server, &get);
+    jw_server_core_register_slow(server, &put);
+    if (!config_apply_timer) {
+        esp_timer_create_args_t timer = { .callback = config_apply_timer_cb, .name = "config_apply" };
+        esp_timer_create(&timer, &config_apply_timer);
+    }
+}
\ No newline at end of file
@@ -1,11 +1,198 @@
 #include "jw_server.h"
 #include "jw_keep_alive.h"
 #include "jw_log.h"
+#include "jw_metrics.h"
+#include "cJSON_Cbor.h"
+#include <inttypes.h>
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+
+#define JW_SERVER_CORE_RECV_CHUNK 512 // Body bytes pulled from the socket per httpd_req_recv
+#define JW_SERVER_CORE_SEND_CHUNK 512 // Scratch buffer for streamed JSON, also the chunk size
+#define JW_SERVER_CORE_SLOW_MAX 8     // Distinct handlers registered with jw_server_core_register_slow
+#define JW_SERVER_CORE_JSON_TOKEN 128 // Longest string or number of a received JSON body
+
+typedef struct {
+    esp_err_t (*handler)(httpd_req_t* req);
+    void* user_ctx;
+} jw_server_core_slow_t;
+
+typedef struct {
+    httpd_req_t* req; // Async copy, completed by the worker
+    const jw_server_core_slow_t* slow;
+    int64_t queued;
+} jw_server_core_work_t;
+
+static QueueHandle_t core_work_queue = NULL;
+static jw_server_core_slow_t core_slow[JW_SERVER_CORE_SLOW_MAX];
+static size_t core_slow_count = 0;
+static uint32_t core_boot_id = 0; // Part of every ETag, generations restart with each boot
+static JW_METRICS_HISTOGRAM_DEFINE(core_queue_seconds, "jw_server_worker_queue_seconds", NULL, "Wait of a slow request for a worker");
+static JW_METRICS_COUNTER_DEFINE(core_rejected, "jw_server_worker_rejected_total", NULL, "Slow requests answered 503, queue full");
+
+typedef struct {
+    httpd_req_t* req;
+    jw_server_gzip_t* gzip; // NULL: plain
+} jw_server_core_http_sink_t;
+
+static cJSON_bool http_chunk_sink(const char* data, size_t length, void* user_data) {
+    jw_server_core_http_sink_t* sink = (jw_server_core_http_sink_t*)user_data;
+    return jw_server_gzip_send_chunk(sink->req, sink->gzip, data, length) == ESP_OK;
+}
+
+// SAX events of a request body turned into a cJSON tree, containers open on the way down
+typedef struct {
+    cJSON* root;
+    cJSON* open[CJSON_SAX_NESTING_LIMIT];
+    size_t depth;
+    char key[JW_SERVER_CORE_JSON_TOKEN]; // Of the next value inside an object, the SAX key is only valid in the call
+} jw_server_core_json_builder_t;
+
+static cJSON_bool json_builder_add(jw_server_core_json_builder_t* builder, cJSON* item) {
+    if (!item) return false;
+    if (builder->depth == 0) {
+        builder->root = item;
+        return true;
+    }
+    cJSON* parent = builder->open[builder->depth - 1];
+    cJSON_bool added = cJSON_IsObject(parent) ? cJSON_AddItemToObject(parent, builder->key, item) : cJSON_AddItemToArray(parent, item);
+    if (!added) cJSON_Delete(item);
+    return added;
+}
+
+static cJSON_bool json_builder_open(jw_server_core_json_builder_t* builder, cJSON* container) {
+    if (builder->depth == CJSON_SAX_NESTING_LIMIT) {
+        cJSON_Delete(container);
+        return false;
+    }
+    if (!json_builder_add(builder, container)) return false;
+    builder->open[builder->depth++] = container;
+    return true;
+}
+
+static cJSON_bool json_builder_start_object(void* user_data) {
+    return json_builder_open((jw_server_core_json_builder_t*)user_data, cJSON_CreateObject());
+}
+
+static cJSON_bool json_builder_start_array(void* user_data) {
+    return json_builder_open((jw_server_core_json_builder_t*)user_data, cJSON_CreateArray());
+}
+
+static cJSON_bool json_builder_close(void* user_data) {
+    ((jw_server_core_json_builder_t*)user_data)->depth--;
+    return true;
+}
+
+static cJSON_bool json_builder_key(const char* key, size_t length, void* user_data) {
+    jw_server_core_json_builder_t* builder = (jw_server_core_json_builder_t*)user_data;
+    memcpy(builder->key, key, length + 1); // Fits, the SAX token buffer has the same size
+    return true;
+}
+
+static cJSON_bool json_builder_string(const char* value, size_t length, void* user_data) {
+    return json_builder_add((jw_server_core_json_builder_t*)user_data, cJSON_CreateString(value));
+}
+
+static cJSON_bool json_builder_number(double value, void* user_data) {
+    return json_builder_add((jw_server_core_json_builder_t*)user_data, cJSON_CreateNumber(value));
+}
+
+static cJSON_bool json_builder_boolean(cJSON_bool value, void* user_data) {
+    return json_builder_add((jw_server_core_json_builder_t*)user_data, cJSON_CreateBool(value));
+}
+
+static cJSON_bool json_builder_null(void* user_data) {
+    return json_builder_add((jw_server_core_json_builder_t*)user_data, cJSON_CreateNull());
+}
+
+static const cJSON_SaxCallbacks json_builder_callbacks = {
+    .start_object = json_builder_start_object,
+    .end_object = json_builder_close,
+    .start_array = json_builder_start_array,
+    .end_array = json_builder_close,
+    .key = json_builder_key,
+    .string = json_builder_string,
+    .number = json_builder_number,
+    .boolean = json_builder_boolean,
+    .null = json_builder_null,
+};
+
+static void jw_server_core_close_session(httpd_handle_t server, int fd) {
+    jw_server_ws_client_closed(fd);
+    close(fd); // A close_fn replaces the server's own close
+}
+
+// Runs slow handlers one at a time, off the server task, so a FATFS wait stalls only this worker
+static void jw_server_core_worker_task(void* arg) {
+    jw_server_core_work_t work;
+    while (1) {
+        if (xQueueReceive(core_work_queue, &work, portMAX_DELAY) != pdTRUE) continue;
+        jw_metrics_observe_since(&core_queue_seconds, work.queued);
+        httpd_handle_t server = work.req->handle;
+        int fd = httpd_req_to_sockfd(work.req);
+        work.req->user_ctx = work.slow->user_ctx;
+        esp_err_t err = work.slow->handler(work.req);
+        httpd_req_async_handler_complete(work.req);
+        if (err != ESP_OK) httpd_sess_trigger_close(server, fd); // What the server does after a failed handler
+    }
+}
+
+static esp_err_t jw_server_core_detach(httpd_req_t* req) {
+    jw_server_core_work_t work = { .slow = (const jw_server_core_slow_t*)req->user_ctx, .queued = jw_metrics_start() };
+    // Only the server task queues work, so the space seen here is still there for xQueueSend
+    if (!core_work_queue || uxQueueSpacesAvailable(core_work_queue) == 0) {
+        jw_metrics_inc(&core_rejected);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        return httpd_resp_send(req, NULL, 0);
+    }
+    if (httpd_req_async_handler_begin(req, &work.req) != ESP_OK) return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+    xQueueSend(core_work_queue, &work, 0);
+    return ESP_OK;
+}
+
+esp_err_t jw_server_core_register_slow(httpd_handle_t server, const httpd_uri_t* uri) {
+    size_t i = 0;
+    while (i < core_slow_count && core_slow[i].handler != uri->handler) i++; // Same slot again after a server restart
+    if (i == JW_SERVER_CORE_SLOW_MAX) {
+        jw_log_msg("Too many slow handlers");
+        return ESP_ERR_NO_MEM;
+    }
+    core_slow[i].handler = uri->handler;
+    core_slow[i].user_ctx = uri->user_ctx;
+    if (i == core_slow_count) core_slow_count++;
+    httpd_uri_t detached = *uri;
+    detached.handler = jw_server_core_detach;
+    detached.user_ctx = &core_slow[i];
+    return httpd_register_uri_handler(server, &detached);
+}
 
 void jw_server_core_init(httpd_handle_t* server) {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 16;
+    config.max_uri_handlers = 32; // API and WS endpoints plus one per embedded asset
     config.stack_size = 8192;
+    config.uri_match_fn = httpd_uri_match_wildcard; // For /sdcard/*, exact URIs still match exactly
+    config.close_fn = jw_server_core_close_session;  // Drops the fd from the WS broadcast registry
+    if (!core_boot_id) core_boot_id = esp_random();
+    if (!core_work_queue) {
+        core_work_queue = xQueueCreate(JW_SERVER_CORE_WORK_QUEUE, sizeof(jw_server_core_work_t));
+        int workers = 0;
+        for (int i = 0; core_work_queue && i < JW_SERVER_CORE_WORKERS; i++) {
+            workers += xTaskCreate(jw_server_core_worker_task, "jw_server_worker", JW_SERVER_CORE_WORKER_STACK, NULL,
+                                   JW_SERVER_CORE_WORKER_PRIORITY, NULL) == pdPASS;
+        }
+        if (core_work_queue && workers == 0) {
+            jw_log_msg("Worker task creation failed"); // Slow handlers answer 503 rather than queue forever
+            vQueueDelete(core_work_queue);
+            core_work_queue = NULL;
+        }
+        jw_metrics_register(&core_queue_seconds);
+        jw_metrics_register(&core_rejected);
+    }
     if (httpd_start(server, &config) == ESP_OK) {
         // xTaskCreate(jw_server_web_server_task, "server", 4096, NULL, 5, NULL);
         // xTaskCreate(jw_server_web_status_task, "status", 4096, NULL, 5, NULL);
@@ -13,7 +200,123 @@ void jw_server_core_init(httpd_handle_t* server) {
     }
 }
 
+void jw_server_core_etag(char* etag, size_t size, const uint32_t* generations, size_t count) {
+    // Weak: the same state is sent plain or gzipped
+    int len = snprintf(etag, size, "W/\"%08" PRIx32, core_boot_id);
+    for (size_t i = 0; i < count && len > 0 && (size_t)len < size; i++) {
+        len += snprintf(etag + len, size - len, "-%" PRIx32, generations[i]);
+    }
+    if (len > 0 && (size_t)len < size) snprintf(etag + len, size - len, "\"");
+}
+
+bool jw_server_core_not_modified(httpd_req_t* req, const char* etag) {
+    char if_none_match[64];
+    httpd_resp_set_hdr(req, "ETag", etag);
+    // A list or a header too long for the buffer simply gets the full response
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) != ESP_OK ||
+        (!strstr(if_none_match, etag) && strcmp(if_none_match, "*") != 0)) {
+        return false;
+    }
+    httpd_resp_set_status(req, "304 Not Modified");
+    httpd_resp_send(req, NULL, 0);
+    return true;
+}
+
 void jw_server_core_parse_json(const char* data, cJSON** json) {
     *json = cJSON_Parse(data);
     if (!*json) jw_log_msg("JSON parse error");
+}
+
+void jw_server_core_parse_json_arena(const char* data, size_t len, cJSON_Arena* arena, cJSON** json) {
+    cJSON_ResetArena(arena); // Previous tree is dropped in one go, no per-node free
+    *json = cJSON_ParseWithArena(data, len, arena); // data is left as it was, the caller can still parse it on the heap
+}
+
+esp_err_t jw_server_core_stream_json(httpd_req_t* req, cJSON_SaxParser* parser) {
+    char chunk[JW_SERVER_CORE_RECV_CHUNK];
+    size_t remaining = req->content_len;
+    cJSON_SaxStatus status = cJSON_SaxOk;
+    while (remaining > 0) {
+        int received = httpd_req_recv(req, chunk, remaining < sizeof(chunk) ? remaining : sizeof(chunk));
+        if (received == HTTPD_SOCK_ERR_TIMEOUT) continue; // Retry, the body is still on its way
+        if (received <= 0) {
+            jw_log_msg("JSON body receive failed");
+            return ESP_FAIL;
+        }
+        remaining -= received;
+        status = cJSON_SaxFeed(parser, chunk, received);
+        if (status != cJSON_SaxOk && status != cJSON_SaxDone) break; // The rest of the body is discarded by httpd
+    }
+    status = cJSON_SaxFinish(parser);
+    if (status != cJSON_SaxDone) {
+        jw_log_msg("JSON stream parse error");
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t jw_server_core_recv_json(httpd_req_t* req, cJSON** json) {
+    char token[JW_SERVER_CORE_JSON_TOKEN];
+    jw_server_core_json_builder_t builder = { 0 };
+    cJSON_SaxParser parser;
+    cJSON_SaxInit(&parser, &json_builder_callbacks, &builder, token, sizeof(token));
+    esp_err_t err = jw_server_core_stream_json(req, &parser);
+    if (err != ESP_OK) {
+        cJSON_Delete(builder.root); // Whatever was built before the body broke off
+        builder.root = NULL;
+    }
+    *json = builder.root;
+    return err;
+}
+
+esp_err_t jw_server_core_send_json_chunked(httpd_req_t* req, const cJSON* json) {
+    char scratch[JW_SERVER_CORE_SEND_CHUNK];
+    httpd_resp_set_type(req, "application/json");
+    jw_server_core_http_sink_t sink = { .req = req, .gzip = jw_server_gzip_begin(req) };
+    if (!cJSON_PrintToSink(json, scratch, sizeof(scratch), false, http_chunk_sink, &sink)) {
+        jw_log_msg("JSON chunked send failed");
+        jw_server_gzip_abort(sink.gzip);
+        return ESP_FAIL; // Unterminated, httpd closes the connection so the client can't take it for the whole body
+    }
+    return jw_server_gzip_send_chunk(req, sink.gzip, NULL, 0); // Terminating chunk
+}
+
+uint8_t* jw_server_core_encode_cbor(const cJSON* json, size_t* len) {
+    *len = cJSON_CborLength(json); // Exact size, the buffer is allocated once
+    if (*len == 0) {
+        jw_log_msg("CBOR encode failed");
+        return NULL;
+    }
+    uint8_t* data = heap_caps_malloc(*len, MALLOC_CAP_SPIRAM);
+    if (!data) {
+        jw_log_msg("CBOR buffer allocation failed");
+        return NULL;
+    }
+    cJSON_PrintCbor(json, data, *len);
+    return data;
+}
+
+char* jw_server_core_print_json(const cJSON* json, size_t* len) {
+    *len = cJSON_PrintLength(json, false);
+    if (*len == 0) {
+        jw_log_msg("JSON print failed");
+        return NULL;
+    }
+    char* text = heap_caps_malloc(*len + 1, MALLOC_CAP_SPIRAM);
+    if (!text) {
+        jw_log_msg("JSON buffer allocation failed");
+        return NULL;
+    }
+    cJSON_PrintPreallocated((cJSON*)json, text, *len + 1, false);
+    return text;
+}
+
+esp_err_t jw_server_core_send_ws_text(httpd_handle_t server, int fd, const char* text, size_t len) {
+    httpd_ws_frame_t frame = { .type = HTTPD_WS_TYPE_TEXT, .payload = (uint8_t*)text, .len = len, .final = true };
+    return httpd_ws_send_frame_async(server, fd, &frame);
+}
+
+esp_err_t jw_server_core_send_ws_binary(httpd_handle_t server, int fd, const uint8_t* data, size_t len) {
+    httpd_ws_frame_t frame = { .type = HTTPD_WS_TYPE_BINARY, .payload = (uint8_t*)data, .len = len, .final = true };
+    return httpd_ws_send_frame_async(server, fd, &frame);
 }
\ No newline at end of file
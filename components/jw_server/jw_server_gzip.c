@@ -0,0 +1,301 @@
+#include "jw_server.h"
+#include "jw_log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+// Deflate (RFC 1951) in a gzip wrapper (RFC 1952): LZ77 over a small sliding window, one block of the fixed Huffman
+// codes. Dynamic codes would gain another ~20% but need every symbol of a block buffered, the fixed ones stream.
+#define JW_SERVER_GZIP_WINDOW_BITS 12 // 4 KB of history, JSON records and log lines repeat well within that
+#define JW_SERVER_GZIP_WINDOW (1 << JW_SERVER_GZIP_WINDOW_BITS)
+#define JW_SERVER_GZIP_HASH_BITS 11
+#define JW_SERVER_GZIP_CHAIN 16       // Earlier positions tried per match, ratio vs CPU
+#define JW_SERVER_GZIP_OUT 1024       // Compressed bytes per chunk
+#define JW_SERVER_GZIP_STREAMS (JW_SERVER_CORE_WORKERS + 1) // Pool, one per worker plus the server task. Further
+                                                            // concurrent responses go out uncompressed
+#define JW_SERVER_GZIP_MIN_MATCH 3
+#define JW_SERVER_GZIP_MAX_MATCH 258
+
+struct jw_server_gzip {
+    uint8_t window[2 * JW_SERVER_GZIP_WINDOW];     // Input, slides down by one window when full
+    uint16_t head[1 << JW_SERVER_GZIP_HASH_BITS];  // Latest position + 1 per hash of 3 bytes, 0: none
+    uint16_t prev[JW_SERVER_GZIP_WINDOW];          // Position + 1 of the previous one with the same hash
+    uint8_t out[JW_SERVER_GZIP_OUT];
+    httpd_req_t* req;
+    size_t start;       // Next window position to encode
+    size_t end;         // Window bytes filled
+    size_t out_len;
+    uint32_t bits;      // Not yet complete output byte, LSB first
+    int bit_count;
+    uint32_t crc;
+    uint32_t size;      // Input bytes mod 2^32, as the trailer wants it
+    bool ok;            // Cleared once a chunk couldn't be sent
+};
+
+// Fixed literal/length codes (RFC 1951 3.2.6) already bit reversed, deflate sends Huffman codes MSB first
+static uint16_t gzip_lit_codes[288];
+static uint8_t gzip_lit_bits[288];
+static uint8_t gzip_dist_codes[30];
+static uint8_t gzip_len_symbol[JW_SERVER_GZIP_MAX_MATCH + 1]; // Length code - 257 per match length
+static uint8_t gzip_dist_symbol[512];                         // Distance code, see gzip_dist_code
+static const uint16_t gzip_len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t gzip_len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t gzip_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+    4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t gzip_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static QueueHandle_t gzip_pool = NULL; // Free compressors, allocated once
+
+static uint16_t gzip_reverse(uint16_t code, int bits) {
+    uint16_t reversed = 0;
+    for (int i = 0; i < bits; i++, code >>= 1) reversed = (reversed << 1) | (code & 1);
+    return reversed;
+}
+
+static void gzip_tables(void) {
+    for (int symbol = 0; symbol < 288; symbol++) {
+        uint16_t code;
+        uint8_t bits;
+        if (symbol < 144) code = 0x30 + symbol, bits = 8;
+        else if (symbol < 256) code = 0x190 + symbol - 144, bits = 9;
+        else if (symbol < 280) code = symbol - 256, bits = 7;
+        else code = 0xc0 + symbol - 280, bits = 8;
+        gzip_lit_codes[symbol] = gzip_reverse(code, bits);
+        gzip_lit_bits[symbol] = bits;
+    }
+    for (int code = 0; code < 30; code++) gzip_dist_codes[code] = gzip_reverse(code, 5);
+    for (int code = 0, len = JW_SERVER_GZIP_MIN_MATCH; len <= JW_SERVER_GZIP_MAX_MATCH; len++) {
+        while (code < 28 && len >= gzip_len_base[code + 1]) code++;
+        gzip_len_symbol[len] = code;
+    }
+    // Distances up to 256 directly, longer ones by (distance - 1) >> 7 like zlib, the codes there span 128 or more
+    for (int code = 0, dist = 1; dist <= 256; dist++) {
+        while (code < 29 && dist >= gzip_dist_base[code + 1]) code++;
+        gzip_dist_symbol[dist - 1] = code;
+    }
+    for (int code = 0, i = 2; i < 256; i++) {
+        while (code < 29 && ((i << 7) + 1) >= gzip_dist_base[code + 1]) code++;
+        gzip_dist_symbol[256 + i] = code;
+    }
+}
+
+static int gzip_dist_code(size_t dist) {
+    return dist <= 256 ? gzip_dist_symbol[dist - 1] : gzip_dist_symbol[256 + ((dist - 1) >> 7)];
+}
+
+static void gzip_flush(jw_server_gzip_t* gzip) {
+    if (gzip->out_len && gzip->ok) gzip->ok = httpd_resp_send_chunk(gzip->req, (const char*)gzip->out, gzip->out_len) == ESP_OK;
+    gzip->out_len = 0;
+}
+
+static void gzip_put_byte(jw_server_gzip_t* gzip, uint8_t byte) {
+    gzip->out[gzip->out_len++] = byte;
+    if (gzip->out_len == JW_SERVER_GZIP_OUT) gzip_flush(gzip);
+}
+
+static void gzip_put_bits(jw_server_gzip_t* gzip, uint32_t value, int count) {
+    gzip->bits |= value << gzip->bit_count;
+    gzip->bit_count += count;
+    while (gzip->bit_count >= 8) {
+        gzip_put_byte(gzip, gzip->bits & 0xff);
+        gzip->bits >>= 8;
+        gzip->bit_count -= 8;
+    }
+}
+
+static void gzip_put_u32(jw_server_gzip_t* gzip, uint32_t value) {
+    for (int i = 0; i < 4; i++, value >>= 8) gzip_put_byte(gzip, value & 0xff);
+}
+
+static void gzip_literal(jw_server_gzip_t* gzip, int symbol) {
+    gzip_put_bits(gzip, gzip_lit_codes[symbol], gzip_lit_bits[symbol]);
+}
+
+static void gzip_match(jw_server_gzip_t* gzip, size_t len, size_t dist) {
+    int code = gzip_len_symbol[len];
+    gzip_literal(gzip, 257 + code);
+    if (gzip_len_extra[code]) gzip_put_bits(gzip, len - gzip_len_base[code], gzip_len_extra[code]);
+    code = gzip_dist_code(dist);
+    gzip_put_bits(gzip, gzip_dist_codes[code], 5);
+    if (gzip_dist_extra[code]) gzip_put_bits(gzip, dist - gzip_dist_base[code], gzip_dist_extra[code]);
+}
+
+static uint32_t gzip_hash(const uint8_t* p) {
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (v * 2654435761u) >> (32 - JW_SERVER_GZIP_HASH_BITS);
+}
+
+static void gzip_insert(jw_server_gzip_t* gzip, size_t pos) {
+    if (pos + JW_SERVER_GZIP_MIN_MATCH > gzip->end) return;
+    uint32_t hash = gzip_hash(gzip->window + pos);
+    gzip->prev[pos & (JW_SERVER_GZIP_WINDOW - 1)] = gzip->head[hash];
+    gzip->head[hash] = pos + 1;
+}
+
+// Longest earlier match for pos within the window, 0 if none of at least JW_SERVER_GZIP_MIN_MATCH
+static size_t gzip_longest(const jw_server_gzip_t* gzip, size_t pos, size_t* dist) {
+    size_t avail = gzip->end - pos;
+    if (avail > JW_SERVER_GZIP_MAX_MATCH) avail = JW_SERVER_GZIP_MAX_MATCH;
+    if (avail < JW_SERVER_GZIP_MIN_MATCH) return 0;
+    const uint8_t* here = gzip->window + pos;
+    size_t best = JW_SERVER_GZIP_MIN_MATCH - 1;
+    unsigned candidate = gzip->head[gzip_hash(here)];
+    for (int chain = JW_SERVER_GZIP_CHAIN; candidate && chain > 0; chain--) {
+        size_t from = candidate - 1;
+        if (pos - from > JW_SERVER_GZIP_WINDOW - 1) break; // Older slots of prev are already reused
+        const uint8_t* there = gzip->window + from;
+        if (there[best] == here[best] && there[0] == here[0]) {
+            size_t len = 0;
+            while (len < avail && there[len] == here[len]) len++;
+            if (len > best) {
+                best = len;
+                *dist = pos - from;
+                if (len == avail) break;
+            }
+        }
+        candidate = gzip->prev[from & (JW_SERVER_GZIP_WINDOW - 1)];
+    }
+    return best >= JW_SERVER_GZIP_MIN_MATCH ? best : 0;
+}
+
+// Encodes what is buffered, except the last JW_SERVER_GZIP_MAX_MATCH bytes unless finishing: a match there could
+// still grow with the next write
+static void gzip_compress(jw_server_gzip_t* gzip, bool finish) {
+    size_t limit = finish ? gzip->end : gzip->end > JW_SERVER_GZIP_MAX_MATCH ? gzip->end - JW_SERVER_GZIP_MAX_MATCH : 0;
+    while (gzip->start < limit) {
+        size_t pos = gzip->start;
+        size_t dist = 0;
+        size_t len = gzip_longest(gzip, pos, &dist);
+        if (len) {
+            gzip_match(gzip, len, dist);
+        } else {
+            gzip_literal(gzip, gzip->window[pos]);
+            len = 1;
+        }
+        for (size_t i = 0; i < len; i++) gzip_insert(gzip, pos + i);
+        gzip->start += len;
+    }
+}
+
+// Moves the second half of the window down, once the first half can no longer be matched against
+static void gzip_slide(jw_server_gzip_t* gzip) {
+    memcpy(gzip->window, gzip->window + JW_SERVER_GZIP_WINDOW, JW_SERVER_GZIP_WINDOW);
+    gzip->start -= JW_SERVER_GZIP_WINDOW;
+    gzip->end -= JW_SERVER_GZIP_WINDOW;
+    for (size_t i = 0; i < sizeof(gzip->head) / sizeof(gzip->head[0]); i++) {
+        gzip->head[i] = gzip->head[i] > JW_SERVER_GZIP_WINDOW ? gzip->head[i] - JW_SERVER_GZIP_WINDOW : 0;
+    }
+    for (size_t i = 0; i < JW_SERVER_GZIP_WINDOW; i++) {
+        gzip->prev[i] = gzip->prev[i] > JW_SERVER_GZIP_WINDOW ? gzip->prev[i] - JW_SERVER_GZIP_WINDOW : 0;
+    }
+}
+
+static void gzip_write(jw_server_gzip_t* gzip, const uint8_t* data, size_t len) {
+    gzip->crc = esp_rom_crc32_le(gzip->crc, data, len);
+    gzip->size += len;
+    while (len > 0 && gzip->ok) {
+        if (gzip->end == sizeof(gzip->window)) gzip_slide(gzip); // start is within JW_SERVER_GZIP_MAX_MATCH of end
+        size_t n = sizeof(gzip->window) - gzip->end;
+        if (n > len) n = len;
+        memcpy(gzip->window + gzip->end, data, n);
+        gzip->end += n;
+        data += n;
+        len -= n;
+        gzip_compress(gzip, false);
+    }
+}
+
+static void gzip_release(jw_server_gzip_t* gzip) {
+    xQueueSend(gzip_pool, &gzip, 0);
+}
+
+// "gzip" listed in Accept-Encoding, and not with q=0
+static bool gzip_accepted(httpd_req_t* req) {
+    char accept[96];
+    if (httpd_req_get_hdr_value_str(req, "Accept-Encoding", accept, sizeof(accept)) != ESP_OK) return false;
+    for (char* token = accept; *token; ) {
+        token += strspn(token, " \t,");
+        size_t len = strcspn(token, " \t;,");
+        bool gzip = len == 4 && strncasecmp(token, "gzip", 4) == 0;
+        token += len;
+        size_t params = strcspn(token, ",");
+        if (gzip) {
+            char* q = strstr(token, "q=");
+            return !(q && q < token + params && strtod(q + 2, NULL) == 0);
+        }
+        token += params;
+    }
+    return false;
+}
+
+void jw_server_gzip_init(void) {
+    if (gzip_pool) return;
+    gzip_tables();
+    gzip_pool = xQueueCreate(JW_SERVER_GZIP_STREAMS, sizeof(jw_server_gzip_t*));
+    for (int i = 0; gzip_pool && i < JW_SERVER_GZIP_STREAMS; i++) {
+        jw_server_gzip_t* gzip = heap_caps_malloc(sizeof(jw_server_gzip_t), MALLOC_CAP_SPIRAM);
+        if (gzip) xQueueSend(gzip_pool, &gzip, 0);
+    }
+    if (gzip_pool && uxQueueMessagesWaiting(gzip_pool) == 0) {
+        jw_log_msg("No memory for gzip, responses go out uncompressed");
+        vQueueDelete(gzip_pool);
+        gzip_pool = NULL;
+    }
+}
+
+jw_server_gzip_t* jw_server_gzip_begin(httpd_req_t* req) {
+    jw_server_gzip_t* gzip = NULL;
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding"); // Caches must not hand the gzip body to other clients
+    if (!gzip_pool || !gzip_accepted(req) || xQueueReceive(gzip_pool, &gzip, 0) != pdTRUE) return NULL;
+    memset(gzip->head, 0, sizeof(gzip->head));
+    gzip->req = req;
+    gzip->start = gzip->end = gzip->out_len = 0;
+    gzip->bits = 0;
+    gzip->bit_count = 0;
+    gzip->crc = 0;
+    gzip->size = 0;
+    gzip->ok = true;
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    static const uint8_t header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff }; // Deflate, no name, no mtime
+    for (size_t i = 0; i < sizeof(header); i++) gzip_put_byte(gzip, header[i]);
+    gzip_put_bits(gzip, 1 | (1 << 1), 3); // BFINAL, BTYPE 01 fixed codes. The only block, it ends with the stream
+    return gzip;
+}
+
+esp_err_t jw_server_gzip_send_chunk(httpd_req_t* req, jw_server_gzip_t* gzip, const char* data, size_t len) {
+    if (!gzip) return httpd_resp_send_chunk(req, data, len);
+    if (len > 0) {
+        gzip_write(gzip, (const uint8_t*)data, len);
+        return gzip->ok ? ESP_OK : ESP_FAIL;
+    }
+    if (gzip->ok) {
+        gzip_compress(gzip, true);
+        gzip_literal(gzip, 256); // End of block
+        if (gzip->bit_count) gzip_put_bits(gzip, 0, 8 - gzip->bit_count);
+        gzip_put_u32(gzip, gzip->crc);
+        gzip_put_u32(gzip, gzip->size);
+        gzip_flush(gzip);
+    }
+    if (!gzip->ok) {
+        gzip_release(gzip); // The body is cut short, no terminating chunk that would pass it off as complete
+        return ESP_FAIL;
+    }
+    gzip_release(gzip);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+void jw_server_gzip_abort(jw_server_gzip_t* gzip) {
+    if (gzip) gzip_release(gzip);
+}
\ No newline at end of file
@@ -1,33 +1,510 @@
 #include "jw_server.h"
+#include "jw_server_assets.h"
 #include "jw_sdcard.h"
+#include "jw_log.h"
+#include "jw_metrics.h"
+#include "cJSON_Cbor.h"
+#include <fcntl.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/unistd.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#define JW_SERVER_HTTP_INDEX "/root.html" // Asset served for "/"
+#define JW_SERVER_HTTP_SD_BUFFER 4096     // Whole sectors, so FATFS reads straight into the DMA capable buffer
+#define JW_SERVER_HTTP_HISTORY_IN (JW_SERVER_HTTP_SD_BUFFER / 2) // History reads the log into one half of a stream
+                                                                  // buffer and collects the response chunk in the other
+#define JW_SERVER_HTTP_HISTORY_LIMIT 500  // Records per page unless the client asks for fewer
+#define JW_SERVER_HTTP_HISTORY_MAX 5000   // Bigger limits are capped, the client pages on with the cursor
+#define JW_SERVER_HTTP_HISTORY_SPAN 86400 // Seconds before "to" when "from" is not given
+#define JW_SERVER_HTTP_METRICS_CHUNK 512 // Scrape output per chunk, well above JW_METRICS_LINE_MAX
+
+typedef struct {
+    httpd_req_t* req;
+    uint8_t* buffer;
+    char dir[40];     // /sdcard/peers/<mac>/data, one YYYY_MM_DD.log per local day
+    uint32_t from;
+    uint32_t to;
+    uint32_t limit;
+    uint32_t day;     // YYYYMMDD of the first file to read, from the cursor
+    uint32_t offset;  // Where to start in that file
+    bool cbor;
+    jw_server_gzip_t* gzip; // NULL: plain
+    char* out;        // Response bytes not sent yet, the second half of buffer
+    size_t out_len;
+    bool ok;          // Cleared once a chunk couldn't be sent
+} http_history_t;
+
+static QueueHandle_t http_sd_buffers = NULL; // Free stream buffers, one per worker, allocated once and reused
+static JW_METRICS_HISTOGRAM_DEFINE(http_root_seconds, "jw_server_handler_seconds", "handler=\"root\"", "HTTP handler latency");
+static JW_METRICS_GAUGE_DEFINE(http_heap_free, "jw_heap_free_bytes", "caps=\"internal\"", "Free heap when scraped");
+static JW_METRICS_GAUGE_DEFINE(http_spiram_free, "jw_heap_free_bytes", "caps=\"spiram\"", "Free heap when scraped");
+
+static const jw_server_asset_t* http_find_asset(const char* uri) {
+    size_t len = strcspn(uri, "?"); // Query string doesn't select the file
+    for (size_t i = 0; i < jw_server_asset_count; i++) {
+        if (strlen(jw_server_assets[i].uri) == len && strncmp(jw_server_assets[i].uri, uri, len) == 0) return &jw_server_assets[i];
+    }
+    return NULL;
+}
+
+static esp_err_t http_send_asset(httpd_req_t* req, const jw_server_asset_t* asset) {
+    httpd_resp_set_hdr(req, "Cache-Control", asset->cache_control);
+    if (jw_server_core_not_modified(req, asset->etag)) return ESP_OK;
+    httpd_resp_set_type(req, asset->type);
+    if (asset->encoding) httpd_resp_set_hdr(req, "Content-Encoding", asset->encoding);
+    return httpd_resp_send(req, (const char*)asset->start, asset->end - asset->start); // Straight from flash
+}
+
+static esp_err_t asset_handler(httpd_req_t* req) {
+    const jw_server_asset_t* asset = http_find_asset(req->uri);
+    if (!asset) return httpd_resp_send_404(req);
+    return http_send_asset(req, asset);
+}
 
 static esp_err_t root_handler(httpd_req_t* req) {
-    const char* html = "/sdcard/index.html";
-    FILE* f = fopen(html, "r");
-    if (f) {
-        char buf[1024];
-        size_t len = fread(buf, 1, sizeof(buf), f);
-        httpd_resp_send(req, buf, len);
-        fclose(f);
-    } else {
-        httpd_resp_send_404(req);
+    int64_t start = jw_metrics_start();
+    const jw_server_asset_t* asset = http_find_asset(JW_SERVER_HTTP_INDEX);
+    esp_err_t err = asset ? http_send_asset(req, asset) : httpd_resp_send_404(req);
+    jw_metrics_observe_since(&http_root_seconds, start);
+    return err;
+}
+
+static const char* http_content_type(const char* path) {
+    const char* ext = strrchr(path, '.');
+    if (!ext) return "application/octet-stream";
+    if (strcmp(ext, ".log") == 0 || strcmp(ext, ".txt") == 0) return "text/plain";
+    if (strcmp(ext, ".csv") == 0) return "text/csv";
+    if (strcmp(ext, ".html") == 0) return "text/html";
+    if (strcmp(ext, ".css") == 0) return "text/css";
+    if (strcmp(ext, ".js") == 0) return "application/javascript";
+    if (strcmp(ext, ".json") == 0) return "application/json";
+    return "application/octet-stream";
+}
+
+// Single "bytes=first-last", "bytes=first-" or "bytes=-suffix" range of a size byte file.
+// ESP_ERR_NOT_FOUND: ignore the header and send everything (malformed or several ranges), ESP_ERR_INVALID_SIZE: 416
+static esp_err_t http_parse_range(const char* value, size_t size, size_t* first, size_t* last) {
+    if (strncmp(value, "bytes=", 6) != 0 || strchr(value, ',')) return ESP_ERR_NOT_FOUND;
+    const char* p = value + 6;
+    char* end = NULL;
+    if (*p == '-') {
+        unsigned long long suffix = strtoull(p + 1, &end, 10);
+        if (end == p + 1 || *end) return ESP_ERR_NOT_FOUND;
+        if (suffix == 0 || size == 0) return ESP_ERR_INVALID_SIZE;
+        *first = suffix >= size ? 0 : size - suffix;
+        *last = size - 1;
+        return ESP_OK;
+    }
+    if (*p < '0' || *p > '9') return ESP_ERR_NOT_FOUND;
+    unsigned long long from = strtoull(p, &end, 10);
+    if (*end != '-') return ESP_ERR_NOT_FOUND;
+    p = end + 1;
+    unsigned long long to = size ? size - 1 : 0;
+    if (*p) {
+        if (*p < '0' || *p > '9') return ESP_ERR_NOT_FOUND;
+        to = strtoull(p, &end, 10);
+        if (*end || to < from) return ESP_ERR_NOT_FOUND;
     }
+    if (from >= size) return ESP_ERR_INVALID_SIZE;
+    *first = from;
+    *last = to >= size ? size - 1 : to;
     return ESP_OK;
 }
 
-static esp_err_t config_handler(httpd_req_t* req) {
-    httpd_resp_send(req, "Config OK", 9);
-    return ESP_OK;
+static void http_sd_set_headers(httpd_req_t* req, const char* type, bool partial, const char* content_range, bool gzip) {
+    httpd_resp_set_type(req, type);
+    if (!gzip) httpd_resp_set_hdr(req, "Accept-Ranges", "bytes"); // Ranges are of the file, a gzip body has none
+    if (partial) {
+        httpd_resp_set_status(req, "206 Partial Content");
+        httpd_resp_set_hdr(req, "Content-Range", content_range);
+    }
+}
+
+// One buffer per worker, so the wait only covers a buffer that is just being handed back
+static uint8_t* http_sd_buffer_take(void) {
+    uint8_t* buffer = NULL;
+    if (http_sd_buffers) xQueueReceive(http_sd_buffers, &buffer, portMAX_DELAY);
+    return buffer;
+}
+
+// Text files go out gzipped when the client takes it, whole files only: a range request wants file offsets
+static jw_server_gzip_t* http_sd_gzip(httpd_req_t* req, const char* type, bool ranged) {
+    if (ranged || (strncmp(type, "text/", 5) != 0 && strcmp(type, "application/json") != 0 && strcmp(type, "application/javascript") != 0)) {
+        return NULL;
+    }
+    return jw_server_gzip_begin(req);
+}
+
+// Copies [offset, offset + length) of fd as a chunked body, through gzip unless it is NULL
+static esp_err_t http_sd_stream(httpd_req_t* req, jw_server_gzip_t* gzip, int fd, off_t offset, size_t length) {
+    uint8_t* buffer = http_sd_buffer_take();
+    if (!buffer) {
+        jw_server_gzip_abort(gzip);
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+    }
+    size_t remaining = length;
+    bool ok = lseek(fd, offset, SEEK_SET) == offset;
+    while (ok && remaining > 0) {
+        ssize_t n = read(fd, buffer, remaining < JW_SERVER_HTTP_SD_BUFFER ? remaining : JW_SERVER_HTTP_SD_BUFFER);
+        if (n <= 0) {
+            ok = false;
+            break;
+        }
+        ok = jw_server_gzip_send_chunk(req, gzip, (const char*)buffer, n) == ESP_OK; // Fails once the client is gone
+        remaining -= n;
+    }
+    xQueueSend(http_sd_buffers, &buffer, 0);
+    if (!ok) {
+        jw_log_msg("SD file stream aborted"); // Headers are out, failing closes the connection mid body
+        jw_server_gzip_abort(gzip);
+        return ESP_FAIL;
+    }
+    return jw_server_gzip_send_chunk(req, gzip, NULL, 0);
+}
+
+// GET /sdcard/<path>, the URI is the VFS path. Small files come from the SPIRAM cache, the rest is streamed.
+// Registered slow: stat, open and every read wait on FATFS, so all of it runs on a worker
+static esp_err_t sd_file_handler(httpd_req_t* req) {
+    char path[128];
+    size_t len = strcspn(req->uri, "?");
+    if (len >= sizeof(path) || strstr(req->uri, "..")) return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad path");
+    memcpy(path, req->uri, len);
+    path[len] = '\0';
+    if (!jw_sdcard_is_mounted()) return httpd_resp_send_404(req);
+
+    struct stat st; // stat, not fstat: FATFS only reports the mtime the cache is keyed by for paths
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return httpd_resp_send_404(req);
+    size_t size = st.st_size;
+    size_t first = 0;
+    size_t last = size ? size - 1 : 0;
+    bool partial = false;
+    bool ranged = false;
+    char range[64];
+    if (httpd_req_get_hdr_value_str(req, "Range", range, sizeof(range)) == ESP_OK) {
+        ranged = true;
+        esp_err_t err = http_parse_range(range, size, &first, &last);
+        if (err == ESP_ERR_INVALID_SIZE) {
+            char content_range[32];
+            snprintf(content_range, sizeof(content_range), "bytes */%u", (unsigned)size);
+            httpd_resp_set_status(req, "416 Range Not Satisfiable");
+            httpd_resp_set_hdr(req, "Content-Range", content_range);
+            return httpd_resp_send(req, NULL, 0);
+        }
+        partial = err == ESP_OK;
+    }
+    size_t length = size ? last - first + 1 : 0;
+    char content_range[48];
+    snprintf(content_range, sizeof(content_range), "bytes %u-%u/%u", (unsigned)first, (unsigned)last, (unsigned)size);
+
+    const char* type = http_content_type(path);
+    jw_server_cache_entry_t* entry = jw_server_cache_get(path, &st);
+    if (entry) {
+        size_t cached_size;
+        const uint8_t* data = jw_server_cache_data(entry, &cached_size);
+        jw_server_gzip_t* gzip = http_sd_gzip(req, type, ranged);
+        http_sd_set_headers(req, type, partial, content_range, gzip != NULL);
+        esp_err_t err;
+        if (gzip) {
+            err = length ? jw_server_gzip_send_chunk(req, gzip, (const char*)data + first, length) : ESP_OK; // 0 would end it
+            if (err == ESP_OK) err = jw_server_gzip_send_chunk(req, gzip, NULL, 0);
+            else jw_server_gzip_abort(gzip);
+        } else {
+            err = httpd_resp_send(req, (const char*)data + first, length);
+        }
+        jw_server_cache_release(entry);
+        return err;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return httpd_resp_send_404(req);
+    jw_server_gzip_t* gzip = http_sd_gzip(req, type, ranged);
+    http_sd_set_headers(req, type, partial, content_range, gzip != NULL);
+    esp_err_t err = http_sd_stream(req, gzip, fd, first, length);
+    close(fd);
+    return err;
+}
+
+static void http_history_write(http_history_t* history, const void* data, size_t len) {
+    char* out = history->out;
+    if (history->out_len + len > JW_SERVER_HTTP_SD_BUFFER - JW_SERVER_HTTP_HISTORY_IN) {
+        history->ok = history->ok && jw_server_gzip_send_chunk(history->req, history->gzip, out, history->out_len) == ESP_OK;
+        history->out_len = 0;
+    }
+    memcpy(out + history->out_len, data, len); // Records and framing are far smaller than the half buffer
+    history->out_len += len;
+}
+
+// YYYYMMDD of the local day a timestamp falls on, the day jw_peers_run_logging_task files it under
+static uint32_t http_history_day(time_t time) {
+    struct tm tm;
+    localtime_r(&time, &tm);
+    return (tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday;
+}
+
+static uint32_t http_history_next_day(uint32_t day) {
+    // Noon, so a DST change can't move the result onto the same or the day after next
+    struct tm tm = { .tm_year = day / 10000 - 1900, .tm_mon = day / 100 % 100 - 1, .tm_mday = day % 100 + 1, .tm_hour = 12, .tm_isdst = -1 };
+    return http_history_day(mktime(&tm));
+}
+
+// "[INFO] [1718000000] name: sensors=[21.30,45.10,0.00], relay=0, switch=1" as written by jw_peers
+static cJSON* http_history_parse(const char* line, uint32_t* timestamp) {
+    const char* stamp = strstr(line, "] [");
+    const char* sensors = strstr(line, "sensors=[");
+    float values[3];
+    int relay, sw;
+    if (!stamp || !sensors) return NULL;
+    char* end = NULL;
+    *timestamp = strtoul(stamp + 3, &end, 10);
+    if (*end != ']' || sscanf(sensors, "sensors=[%f,%f,%f], relay=%d, switch=%d", &values[0], &values[1], &values[2], &relay, &sw) != 5) return NULL;
+    cJSON* record = cJSON_CreateObject();
+    cJSON_AddNumberToObject(record, "timestamp", *timestamp);
+    cJSON* list = cJSON_CreateFloatArray(values, 3);
+    cJSON_SetNumberPrecision(list, 2);
+    cJSON_AddItemToObject(record, "values", list);
+    cJSON_AddBoolToObject(record, "relay", relay);
+    cJSON_AddBoolToObject(record, "switch", sw);
+    return record;
+}
+
+// Earliest and latest day with a log file in [first, last], false if there is none
+static bool http_history_days(const char* dir, uint32_t* first, uint32_t* last) {
+    DIR* d = opendir(dir);
+    if (!d) return false;
+    uint32_t lo = UINT32_MAX, hi = 0;
+    struct dirent* entry;
+    while ((entry = readdir(d))) {
+        unsigned year, month, mday;
+        if (sscanf(entry->d_name, "%4u_%2u_%2u", &year, &month, &mday) != 3) continue;
+        uint32_t day = year * 10000 + month * 100 + mday;
+        if (day < *first || day > *last) continue;
+        if (day < lo) lo = day;
+        if (day > hi) hi = day;
+    }
+    closedir(d);
+    *first = lo;
+    *last = hi;
+    return lo <= hi;
+}
+
+// Streams one file from offset, adding matching records until the page is full. Returns false once it is, with the
+// offset of the first record left out in *next
+static bool http_history_file(http_history_t* history, const char* path, uint32_t offset, uint32_t* count, uint32_t* next) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return true; // No readings that day
+    char* in = (char*)history->buffer;
+    size_t have = 0;
+    bool skip = false; // Rest of a line too long for the buffer, it's not a reading
+    bool more = lseek(fd, offset, SEEK_SET) == offset;
+    while (more && history->ok) {
+        ssize_t n = read(fd, in + have, JW_SERVER_HTTP_HISTORY_IN - 1 - have);
+        if (n <= 0) break;
+        have += n;
+        char* line = in;
+        char* newline;
+        while ((newline = memchr(line, '\n', in + have - line))) {
+            *newline = '\0';
+            uint32_t timestamp;
+            cJSON* record = skip ? NULL : http_history_parse(line, &timestamp);
+            skip = false;
+            if (record && timestamp >= history->from && timestamp <= history->to) {
+                if (*count == history->limit) {
+                    *next = offset + (line - in);
+                    cJSON_Delete(record);
+                    more = false;
+                    break;
+                }
+                char text[160];
+                uint8_t cbor[96];
+                if (history->cbor) {
+                    size_t len = cJSON_PrintCbor(record, cbor, sizeof(cbor));
+                    if (len) http_history_write(history, cbor, len);
+                } else if (cJSON_PrintPreallocated(record, text, sizeof(text), false)) {
+                    if (*count) http_history_write(history, ",", 1);
+                    http_history_write(history, text, strlen(text));
+                }
+                (*count)++;
+            }
+            cJSON_Delete(record);
+            line = newline + 1;
+        }
+        if (!more) break;
+        size_t used = line - in;
+        if (used == 0 && have == JW_SERVER_HTTP_HISTORY_IN - 1) {
+            used = have; // No newline in a full buffer, drop what's there and the rest of that line
+            skip = true;
+        }
+        memmove(in, line, have - used);
+        have -= used;
+        offset += used;
+    }
+    close(fd);
+    return more;
+}
+
+static esp_err_t http_history_send(http_history_t* history) {
+    httpd_req_t* req = history->req;
+    history->out = (char*)history->buffer + JW_SERVER_HTTP_HISTORY_IN;
+    history->ok = true;
+    httpd_resp_set_type(req, history->cbor ? "application/cbor" : "application/json");
+    history->gzip = jw_server_gzip_begin(req); // CBOR too, the keys still repeat in every record
+    // {"records":[...],"cursor":"..."|null}, in CBOR as an indefinite map and array since the count isn't known yet
+    if (history->cbor) http_history_write(history, "\xbf\x67records\x9f", 10);
+    else http_history_write(history, "{\"records\":[", 12);
+
+    uint32_t first = history->day ? history->day : http_history_day(history->from);
+    uint32_t last = http_history_day(history->to);
+    uint32_t count = 0;
+    uint32_t next = 0;
+    uint32_t day = 0;
+    if (first <= last && http_history_days(history->dir, &first, &last)) {
+        for (day = first; day <= last && history->ok; day = http_history_next_day(day)) {
+            char path[64];
+            snprintf(path, sizeof(path), "%s/%04u_%02u_%02u.log", history->dir,
+                (unsigned)(day / 10000), (unsigned)(day / 100 % 100), (unsigned)(day % 100));
+            if (!http_history_file(history, path, day == history->day ? history->offset : 0, &count, &next)) break;
+        }
+    }
+
+    char cursor[20];
+    bool more = day && day <= last && count == history->limit; // Stopped on a record past the page
+    snprintf(cursor, sizeof(cursor), "%08x%08x", (unsigned)day, (unsigned)next);
+    if (history->cbor) {
+        http_history_write(history, "\xff\x66" "cursor", 8);
+        if (more) {
+            http_history_write(history, "\x70", 1); // 16 byte text string
+            http_history_write(history, cursor, 16);
+        } else {
+            http_history_write(history, "\xf6", 1); // null
+        }
+        http_history_write(history, "\xff", 1);
+    } else {
+        http_history_write(history, "],\"cursor\":", 11);
+        if (more) {
+            http_history_write(history, "\"", 1);
+            http_history_write(history, cursor, 16);
+            http_history_write(history, "\"", 1);
+        } else {
+            http_history_write(history, "null", 4);
+        }
+        http_history_write(history, "}", 1);
+    }
+    if (history->ok && history->out_len) history->ok = jw_server_gzip_send_chunk(req, history->gzip, history->out, history->out_len) == ESP_OK;
+    if (!history->ok) {
+        jw_log_msg("History stream aborted");
+        jw_server_gzip_abort(history->gzip);
+        return ESP_FAIL;
+    }
+    return jw_server_gzip_send_chunk(req, history->gzip, NULL, 0);
+}
+
+// GET /api/peers/<mac>/history?from=&to=&limit=&cursor=&format=cbor
+// from/to are unix seconds (default: the last day), cursor is the value returned with the previous page.
+// Registered slow, it runs on a worker
+static esp_err_t history_handler(httpd_req_t* req) {
+    unsigned mac[6];
+    int end = 0;
+    if (sscanf(req->uri, "/api/peers/%2x:%2x:%2x:%2x:%2x:%2x/history%n", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5], &end) != 6 ||
+        end == 0 || (req->uri[end] != '\0' && req->uri[end] != '?')) {
+        return httpd_resp_send_404(req);
+    }
+    if (!jw_sdcard_is_mounted()) return httpd_resp_send_404(req);
+
+    char query[128] = "";
+    char value[24];
+    httpd_req_get_url_query_str(req, query, sizeof(query));
+    uint32_t to = httpd_query_key_value(query, "to", value, sizeof(value)) == ESP_OK ? strtoul(value, NULL, 10) : (uint32_t)time(NULL);
+    uint32_t from = to > JW_SERVER_HTTP_HISTORY_SPAN ? to - JW_SERVER_HTTP_HISTORY_SPAN : 0;
+    if (httpd_query_key_value(query, "from", value, sizeof(value)) == ESP_OK) from = strtoul(value, NULL, 10);
+    uint32_t limit = JW_SERVER_HTTP_HISTORY_LIMIT;
+    if (httpd_query_key_value(query, "limit", value, sizeof(value)) == ESP_OK) limit = strtoul(value, NULL, 10);
+    unsigned day = 0, offset = 0;
+    if (httpd_query_key_value(query, "cursor", value, sizeof(value)) == ESP_OK &&
+        (strlen(value) != 16 || sscanf(value, "%8x%8x", &day, &offset) != 2)) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad cursor");
+    }
+    if (limit > JW_SERVER_HTTP_HISTORY_MAX) limit = JW_SERVER_HTTP_HISTORY_MAX;
+    if (from > to || limit == 0) return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad range");
+
+    http_history_t history = { .req = req, .from = from, .to = to, .limit = limit, .day = day, .offset = offset };
+    snprintf(history.dir, sizeof(history.dir), JW_SDCARD_MOUNT_POINT "/peers/%02x:%02x:%02x:%02x:%02x:%02x/data",
+        mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]); // Lower case, as jw_peers names the directories
+    history.cbor = httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK && strcmp(value, "cbor") == 0;
+    history.buffer = http_sd_buffer_take(); // Shares the SD stream buffers with downloads
+    if (!history.buffer) return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+    esp_err_t err = http_history_send(&history);
+    xQueueSend(http_sd_buffers, &history.buffer, 0);
+    return err;
+}
+
+typedef struct {
+    httpd_req_t* req;
+    jw_server_gzip_t* gzip;
+} http_metrics_out_t;
+
+static bool http_metrics_sink(const char* data, size_t len, void* user_data) {
+    http_metrics_out_t* out = (http_metrics_out_t*)user_data;
+    return jw_server_gzip_send_chunk(out->req, out->gzip, data, len) == ESP_OK;
+}
+
+// GET /api/metrics: every registered jw_metrics metric in the Prometheus text format, streamed in chunks
+static esp_err_t metrics_handler(httpd_req_t* req) {
+    char scratch[JW_SERVER_HTTP_METRICS_CHUNK];
+    jw_metrics_gauge_set(&http_heap_free, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    jw_metrics_gauge_set(&http_spiram_free, heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    httpd_resp_set_type(req, "text/plain; version=0.0.4; charset=utf-8");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    http_metrics_out_t out = { .req = req, .gzip = jw_server_gzip_begin(req) };
+    if (jw_metrics_write(scratch, sizeof(scratch), http_metrics_sink, &out) != ESP_OK) {
+        jw_log_msg("Metrics send failed");
+        jw_server_gzip_abort(out.gzip);
+        return ESP_FAIL; // Unterminated, a scraper must not take the cut off exposition for a complete one
+    }
+    return jw_server_gzip_send_chunk(req, out.gzip, NULL, 0); // Terminating chunk
 }
 
 void jw_server_http_start(httpd_handle_t server) {
     httpd_uri_t root = { .uri = "/", .method = HTTP_GET, .handler = root_handler };
-    httpd_uri_t config = { .uri = "/api/config", .method = HTTP_GET, .handler = config_handler };
+    httpd_uri_t sd_file = { .uri = JW_SDCARD_MOUNT_POINT "/*", .method = HTTP_GET, .handler = sd_file_handler };
+    httpd_uri_t history = { .uri = "/api/peers/*", .method = HTTP_GET, .handler = history_handler };
+    httpd_uri_t metrics = { .uri = "/api/metrics", .method = HTTP_GET, .handler = metrics_handler };
     httpd_register_uri_handler(server, &root);
-    httpd_register_uri_handler(server, &config);
+    jw_server_core_register_slow(server, &sd_file);
+    jw_server_core_register_slow(server, &history);
+    httpd_register_uri_handler(server, &metrics);
+    jw_metrics_register(&http_root_seconds);
+    jw_metrics_register(&http_heap_free);
+    jw_metrics_register(&http_spiram_free);
+    for (size_t i = 0; i < jw_server_asset_count; i++) {
+        httpd_uri_t asset = { .uri = jw_server_assets[i].uri, .method = HTTP_GET, .handler = asset_handler };
+        httpd_register_uri_handler(server, &asset);
+    }
+    jw_server_cache_init();
+    jw_server_gzip_init();
+    if (!http_sd_buffers) {
+        http_sd_buffers = xQueueCreate(JW_SERVER_CORE_WORKERS, sizeof(uint8_t*));
+        for (int i = 0; http_sd_buffers && i < JW_SERVER_CORE_WORKERS; i++) {
+            uint8_t* buffer = heap_caps_malloc(JW_SERVER_HTTP_SD_BUFFER, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            if (buffer) xQueueSend(http_sd_buffers, &buffer, 0);
+        }
+        if (http_sd_buffers && uxQueueMessagesWaiting(http_sd_buffers) == 0) {
+            vQueueDelete(http_sd_buffers); // Nothing to wait for, SD requests fail instead
+            http_sd_buffers = NULL;
+        }
+    }
     jw_log_msg("HTTP endpoints registered");
 }
 
 void jw_server_http_stop(void) {
-    // Cleanup if needed
+    uint32_t hits, misses;
+    size_t bytes;
+    jw_server_cache_stats(&hits, &misses, &bytes);
+    char msg[80];
+    snprintf(msg, sizeof(msg), "SD cache: %u hits, %u misses, %u bytes", (unsigned)hits, (unsigned)misses, (unsigned)bytes);
+    jw_log_msg(msg);
+    jw_server_cache_clear(); // Files may change while the server is down
 }
\ No newline at end of file
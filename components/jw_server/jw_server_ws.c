@@ -2,52 +2,1010 @@
 #include "jw_peers.h"
 #include "jw_espnow.h"
 #include "jw_keep_alive.h"
+#include "jw_metrics.h"
+#include "cJSON_Bind.h"
+#include "cJSON_Patch.h"
+#include "cJSON_Cbor.h"
+#include <ctype.h>
+#include "esp_mac.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
 
-static void ws_handler(httpd_req_t* req) {
+#define WS_CLIENT_QUEUE_LEN 8     // Outbound messages per client, a stalled client loses the oldest first
+#define WS_COALESCE_KEY_LEN 24    // MAC strings and WS_PEERS_KEY
+#define WS_FLUSH_RETRY_US 50000   // Clients whose socket buffer was full are retried this often
+#define WS_PEERS_KEY "peers"      // Coalescing key of the peer table messages, at most one queued per client
+#define WS_RX_POOL_BUFFERS 4      // Internal RAM receive buffers, single commands never touch the heap
+#define WS_RX_POOL_BUFFER 512
+#define WS_RX_MAX_MESSAGE (32 * 1024) // Reassembled size limit, bigger messages close the connection
+#define WS_CMD_ARENA 2048         // Tree of a text command batch, bigger batches are parsed on the heap
+#define WS_TOPIC_LEN 64           // Whole topic or filter, "telemetry/AA:BB:CC:DD:EE:FF"
+#define WS_TOPIC_SEGMENT 18       // One level, a MAC string is the longest
+#define WS_TOPIC_NODES 64         // Trie nodes shared by every subscription of every client
+#define WS_PEERS_TOPIC "peers"
+#define WS_CMD_SUBSCRIBE 12       // {"type":12,"key":"subscribe"|"unsubscribe","val":"telemetry/+"}
+#define WS_EVENT_HISTORY 32       // Published events kept for /events clients resuming with Last-Event-ID
+#define WS_SSE_PING_US 15000000   // Comment line to idle /events streams, keeps proxies from timing them out
+#define WS_SSE_TOPICS "peers,telemetry/+" // /events subscriptions without ?topics=
+#define WS_STOP_TIMEOUT_MS 2000   // Wait for the server task to run the teardown before the server is stopped anyway
+
+// {"type":9,"key":"confirm_peer","val":"AA:BB:CC:DD:EE:FF"} from the UI
+typedef struct {
+    int type;
+    char key[32];
+    char val[64];
+} ws_command_t;
+
+static const cJSON_BindField ws_command_fields[] = {
+    CJSON_BIND_INT(ws_command_t, type, "type", cJSON_BindRequired, 0, 0),
+    CJSON_BIND_STRING(ws_command_t, key, "key", cJSON_BindRequired),
+    CJSON_BIND_STRING(ws_command_t, val, "val", 0),
+};
+
+typedef enum {
+    WS_ENDPOINT_MAIN = 0, // Subscribes to what it needs, /ws/nodes and /ws/peers are kept for the older pages
+    WS_ENDPOINT_NODES,
+    WS_ENDPOINT_PEERS,
+    WS_ENDPOINT_COUNT,
+} ws_endpoint_id_t;
+
+typedef enum {
+    WS_ENCODING_TEXT = 0, // JSON in a text frame
+    WS_ENCODING_CBOR,     // Connected with ?format=cbor
+    WS_ENCODING_SSE,      // GET /events, JSON in an event-stream record over a chunked response
+} ws_encoding_t;
+
+// Rendered once per broadcast and referenced from the queue of every client it goes to
+typedef struct {
+    int refs;
+    uint32_t id; // Event id, the SSE record carries it for Last-Event-ID
+    cJSON* json; // Until the producer is done with it, recipients only use the rendered copies
+    char* text;
+    size_t text_len;
+    uint8_t* cbor;
+    size_t cbor_len;
+    char* sse;
+    size_t sse_len;
+} ws_message_t;
+
+typedef struct {
+    ws_message_t* msg;
+    char key[WS_COALESCE_KEY_LEN]; // A queued message with the same key is replaced, "" never coalesces
+} ws_slot_t;
+
+// Session context of a WS client, freed by the server after the close callback unregistered it
+typedef struct {
+    int fd;
+    size_t slot; // In ws_clients, also its bit in the topic subscriber sets
+    const char* uri;
+    ws_encoding_t encoding;
+    httpd_req_t* sse; // Async request of an /events stream, the client is ours to free instead of the session's
+    bool synced;  // Holds ws_peers_snapshot and gets merge patches against it
+    bool closing; // Send failed, close triggered, nothing more is queued
+    ws_slot_t queue[WS_CLIENT_QUEUE_LEN]; // Ring, oldest at head
+    size_t head;
+    size_t depth;
+    uint32_t sent;
+    uint32_t dropped;   // Pushed out by newer messages while the client stalled
+    uint32_t coalesced; // Replaced by a newer value with the same key before it was sent
+    httpd_ws_type_t rx_type; // TEXT or BINARY while a message is being received, CONTINUE between messages
+    uint8_t* rx;             // Fragments received so far, from ws_rx_pool or PSRAM
+    size_t rx_len;
+    size_t rx_cap;
+} ws_client_t;
+
+typedef struct {
+    const char* uri;
+    const char* topic; // Subscribed on connect, NULL: none until the client asks
+} ws_endpoint_t;
+
+// Clients as bits indexed by ws_client_t.slot
+typedef uint32_t ws_client_set_t[(CONFIG_LWIP_MAX_SOCKETS + 31) / 32];
+
+// One topic level ("telemetry", a MAC, or the wildcards "+" and "#"). Children are a sibling list, links are indices
+// into ws_topics and 0 ends a list (the root at 0 is nobody's child)
+typedef struct {
+    bool used;
+    char segment[WS_TOPIC_SEGMENT];
+    uint8_t child;
+    uint8_t next;
+    ws_client_set_t subscribers; // Clients whose filter ends at this node
+} ws_topic_node_t;
+
+typedef struct {
+    char topic[WS_TOPIC_LEN];
+    char key[WS_COALESCE_KEY_LEN];
+    cJSON* json;
+} ws_publish_t;
+
+typedef struct {
+    ws_message_t* msg; // NULL until the ring first wraps
+    char topic[WS_TOPIC_LEN];
+    char key[WS_COALESCE_KEY_LEN];
+} ws_event_t;
+
+static httpd_handle_t ws_server = NULL;       // Server task side, cleared by ws_teardown
+static httpd_handle_t ws_queue_server = NULL; // Other tasks queueing work, cleared first by jw_server_ws_stop
+static SemaphoreHandle_t ws_queue_lock = NULL;
+static esp_timer_handle_t ws_flush_timer = NULL;
+static esp_timer_handle_t ws_ping_timer = NULL;
+static uint32_t ws_event_id = 0; // Last id handed out, restarts with the controller
+static ws_event_t ws_events[WS_EVENT_HISTORY]; // Ring of published events, oldest at ws_events_next
+static size_t ws_events_next = 0;
+static uint8_t ws_rx_pool[WS_RX_POOL_BUFFERS][WS_RX_POOL_BUFFER];
+static bool ws_rx_pool_used[WS_RX_POOL_BUFFERS];
+static uint8_t ws_cmd_arena_buf[WS_CMD_ARENA];
+static cJSON_Arena ws_cmd_arena;
+static cJSON* ws_peers_snapshot = NULL; // Peer table as last queued
+static JW_METRICS_HISTOGRAM_DEFINE(ws_handler_seconds, "jw_server_handler_seconds", "handler=\"ws\"", "HTTP handler latency");
+static JW_METRICS_HISTOGRAM_DEFINE(ws_send_seconds, "jw_server_ws_send_seconds", NULL, "WS frame or SSE chunk send latency");
+
+// Clients are added on handshake and removed by the session close callback. Handlers, the close callback and
+// httpd_queue_work items all run in the server task, so the registry, the topics, the queues and the peer snapshot
+// need no lock
+static ws_client_t* ws_clients[CONFIG_LWIP_MAX_SOCKETS];
+static ws_topic_node_t ws_topics[WS_TOPIC_NODES];
+
+static const ws_endpoint_t ws_endpoints[WS_ENDPOINT_COUNT] = {
+    [WS_ENDPOINT_MAIN] = { .uri = "/ws" },
+    [WS_ENDPOINT_NODES] = { .uri = "/ws/nodes", .topic = WS_PEERS_TOPIC },
+    [WS_ENDPOINT_PEERS] = { .uri = "/ws/peers" },
+};
+
+static void ws_peers_sync(ws_client_t* client);
+static cJSON* ws_build_peers_json(void);
+
+static const ws_endpoint_t* ws_endpoint_find(const char* uri) {
+    size_t len = strcspn(uri, "?");
+    for (size_t i = 0; i < WS_ENDPOINT_COUNT; i++) {
+        if (strlen(ws_endpoints[i].uri) == len && strncmp(ws_endpoints[i].uri, uri, len) == 0) return &ws_endpoints[i];
+    }
+    return NULL;
+}
+
+static void ws_set_add(ws_client_set_t set, size_t slot) {
+    set[slot / 32] |= 1u << (slot % 32);
+}
+
+static void ws_set_remove(ws_client_set_t set, size_t slot) {
+    set[slot / 32] &= ~(1u << (slot % 32));
+}
+
+static bool ws_set_has(const ws_client_set_t set, size_t slot) {
+    return (set[slot / 32] >> (slot % 32)) & 1u;
+}
+
+static bool ws_set_empty(const ws_client_set_t set) {
+    for (size_t i = 0; i < sizeof(ws_client_set_t) / sizeof(set[0]); i++) {
+        if (set[i]) return false;
+    }
+    return true;
+}
+
+static void ws_set_merge(ws_client_set_t into, const ws_client_set_t from) {
+    for (size_t i = 0; i < sizeof(ws_client_set_t) / sizeof(into[0]); i++) into[i] |= from[i];
+}
+
+// Levels split by '/', none empty or longer than a MAC. Filters may use "+" for one level and a trailing "#" for the
+// level it's on and everything below
+static bool ws_topic_valid(const char* topic, bool filter) {
+    const char* level = topic;
+    while (true) {
+        size_t len = strcspn(level, "/");
+        if (len == 0 || len >= WS_TOPIC_SEGMENT) return false;
+        bool wildcard = memchr(level, '+', len) || memchr(level, '#', len);
+        if (wildcard && (!filter || len != 1 || (level[0] == '#' && level[len] != '\0'))) return false;
+        if (level[len] == '\0') return true;
+        level += len + 1;
+    }
+}
+
+static uint8_t ws_topic_child(uint8_t node, const char* segment, size_t len) {
+    for (uint8_t i = ws_topics[node].child; i; i = ws_topics[i].next) {
+        if (strlen(ws_topics[i].segment) == len && strncmp(ws_topics[i].segment, segment, len) == 0) return i;
+    }
+    return 0;
+}
+
+// Frees the nodes below node that lead to no subscriber, true if node has none left either
+static bool ws_topic_prune(uint8_t node) {
+    uint8_t* link = &ws_topics[node].child;
+    while (*link) {
+        uint8_t child = *link;
+        if (ws_topic_prune(child)) {
+            *link = ws_topics[child].next;
+            ws_topics[child].used = false;
+        } else {
+            link = &ws_topics[child].next;
+        }
+    }
+    return !ws_topics[node].child && ws_set_empty(ws_topics[node].subscribers);
+}
+
+// Node of the filter, created level by level when create is set. 0: not there, or no free node
+static uint8_t ws_topic_find(const char* filter, bool create) {
+    uint8_t node = 0;
+    const char* level = filter;
+    while (true) {
+        size_t len = strcspn(level, "/");
+        uint8_t child = ws_topic_child(node, level, len);
+        if (!child && create) {
+            for (child = 1; child < WS_TOPIC_NODES && ws_topics[child].used; child++);
+            if (child == WS_TOPIC_NODES) {
+                ws_topic_prune(0); // Levels created so far lead nowhere
+                return 0;
+            }
+            memset(&ws_topics[child], 0, sizeof(ws_topic_node_t));
+            ws_topics[child].used = true;
+            memcpy(ws_topics[child].segment, level, len);
+            ws_topics[child].next = ws_topics[node].child;
+            ws_topics[node].child = child;
+        }
+        if (!child) return 0;
+        node = child;
+        if (level[len] == '\0') return node;
+        level += len + 1;
+    }
+}
+
+// Adds the subscribers of every filter below node that matches the rest of the topic
+static void ws_topic_match(uint8_t node, const char* topic, ws_client_set_t matched) {
+    size_t len = strcspn(topic, "/");
+    for (uint8_t i = ws_topics[node].child; i; i = ws_topics[i].next) {
+        const char* segment = ws_topics[i].segment;
+        if (strcmp(segment, "#") == 0) {
+            ws_set_merge(matched, ws_topics[i].subscribers);
+        } else if (strcmp(segment, "+") == 0 || (strlen(segment) == len && strncmp(segment, topic, len) == 0)) {
+            if (topic[len] != '\0') {
+                ws_topic_match(i, topic + len + 1, matched);
+                continue;
+            }
+            ws_set_merge(matched, ws_topics[i].subscribers);
+            uint8_t all = ws_topic_child(i, "#", 1); // "telemetry/#" gets "telemetry" as well
+            if (all) ws_set_merge(matched, ws_topics[all].subscribers);
+        }
+    }
+}
+
+static void ws_topic_subscribers(const char* topic, ws_client_set_t matched) {
+    memset(matched, 0, sizeof(ws_client_set_t));
+    ws_topic_match(0, topic, matched);
+}
+
+static void ws_topic_remove_client(size_t slot) {
+    for (size_t i = 0; i < WS_TOPIC_NODES; i++) ws_set_remove(ws_topics[i].subscribers, slot);
+    ws_topic_prune(0);
+}
+
+// Filters of one client, path holds the levels above node
+static void ws_topic_list(uint8_t node, char* path, size_t path_len, size_t slot, cJSON* list) {
+    for (uint8_t i = ws_topics[node].child; i; i = ws_topics[i].next) {
+        int len = snprintf(path + path_len, WS_TOPIC_LEN - path_len, "%s%s", path_len ? "/" : "", ws_topics[i].segment);
+        if (path_len + len >= WS_TOPIC_LEN) continue;
+        if (ws_set_has(ws_topics[i].subscribers, slot)) cJSON_AddItemToArray(list, cJSON_CreateString(path));
+        ws_topic_list(i, path, path_len + len, slot, list);
+    }
+}
+
+static ws_message_t* ws_message_new(cJSON* json) {
+    if (!json) return NULL;
+    ws_message_t* msg = calloc(1, sizeof(ws_message_t));
+    if (!msg) {
+        cJSON_Delete(json);
+        return NULL;
+    }
+    msg->refs = 1; // The producer's
+    msg->id = ++ws_event_id;
+    msg->json = json;
+    return msg;
+}
+
+// "id: 42\ndata: <json>\n\n", unformatted JSON has no line breaks so one data line holds it
+static bool ws_message_render_sse(ws_message_t* msg) {
+    char head[24];
+    int head_len = snprintf(head, sizeof(head), "id: %u\ndata: ", (unsigned)msg->id);
+    msg->sse = heap_caps_malloc(head_len + msg->text_len + 2, MALLOC_CAP_SPIRAM);
+    if (!msg->sse) return false;
+    memcpy(msg->sse, head, head_len);
+    memcpy(msg->sse + head_len, msg->text, msg->text_len);
+    memcpy(msg->sse + head_len + msg->text_len, "\n\n", 2);
+    msg->sse_len = head_len + msg->text_len + 2;
+    return true;
+}
+
+// Renders the encoding the client needs, once for all clients
+static bool ws_message_render(ws_message_t* msg, ws_encoding_t encoding) {
+    if (encoding == WS_ENCODING_CBOR) {
+        if (!msg->cbor) msg->cbor = jw_server_core_encode_cbor(msg->json, &msg->cbor_len);
+        return msg->cbor != NULL;
+    }
+    if (!msg->text) msg->text = jw_server_core_print_json(msg->json, &msg->text_len);
+    if (encoding == WS_ENCODING_SSE && msg->text && !msg->sse) ws_message_render_sse(msg);
+    return encoding == WS_ENCODING_SSE ? msg->sse != NULL : msg->text != NULL;
+}
+
+static void ws_message_unref(ws_message_t* msg) {
+    if (!msg || --msg->refs > 0) return;
+    cJSON_Delete(msg->json);
+    heap_caps_free(msg->text);
+    heap_caps_free(msg->cbor);
+    heap_caps_free(msg->sse);
+    free(msg);
+}
+
+// Producer side: the tree goes (it may reference data the producer frees next), the rendered copies stay queued
+static void ws_message_done(ws_message_t* msg) {
+    if (!msg) return;
+    cJSON_Delete(msg->json);
+    msg->json = NULL;
+    ws_message_unref(msg);
+}
+
+static ws_slot_t* ws_client_slot(ws_client_t* client, size_t i) {
+    return &client->queue[(client->head + i) % WS_CLIENT_QUEUE_LEN];
+}
+
+static bool ws_client_has_queued(ws_client_t* client, const char* key) {
+    for (size_t i = 0; i < client->depth; i++) {
+        if (strcmp(ws_client_slot(client, i)->key, key) == 0) return true;
+    }
+    return false;
+}
+
+static void ws_client_pop(ws_client_t* client) {
+    ws_slot_t* slot = ws_client_slot(client, 0);
+    ws_message_unref(slot->msg);
+    slot->msg = NULL;
+    client->head = (client->head + 1) % WS_CLIENT_QUEUE_LEN;
+    client->depth--;
+}
+
+static void ws_client_push(ws_client_t* client, ws_message_t* msg, const char* key) {
+    if (client->closing) return;
+    if (key && key[0]) {
+        for (size_t i = 0; i < client->depth; i++) {
+            ws_slot_t* slot = ws_client_slot(client, i);
+            if (strcmp(slot->key, key) == 0) {
+                msg->refs++; // Latest value wins, in the position of the one it replaces
+                ws_message_unref(slot->msg);
+                slot->msg = msg;
+                client->coalesced++;
+                return;
+            }
+        }
+    }
+    if (client->depth == WS_CLIENT_QUEUE_LEN) {
+        // A dropped peer table breaks the patch chain, the client starts over with the full table
+        if (strcmp(ws_client_slot(client, 0)->key, WS_PEERS_KEY) == 0) client->synced = false;
+        ws_client_pop(client);
+        client->dropped++;
+    }
+    ws_slot_t* slot = ws_client_slot(client, client->depth++);
+    msg->refs++;
+    slot->msg = msg;
+    snprintf(slot->key, sizeof(slot->key), "%s", key ? key : "");
+}
+
+static bool ws_rx_is_pooled(const uint8_t* data) {
+    return data >= ws_rx_pool[0] && data < ws_rx_pool[WS_RX_POOL_BUFFERS];
+}
+
+static void ws_rx_release(ws_client_t* client) {
+    if (ws_rx_is_pooled(client->rx)) ws_rx_pool_used[(client->rx - ws_rx_pool[0]) / WS_RX_POOL_BUFFER] = false;
+    else heap_caps_free(client->rx);
+    client->rx = NULL;
+    client->rx_len = client->rx_cap = 0;
+    client->rx_type = HTTPD_WS_TYPE_CONTINUE;
+}
+
+// Room for needed bytes of message, a pool buffer while it fits, PSRAM (grown by doubling) once it doesn't
+static bool ws_rx_reserve(ws_client_t* client, size_t needed) {
+    if (needed <= client->rx_cap) return true;
+    if (needed > WS_RX_MAX_MESSAGE) return false;
+    if (!client->rx && needed <= WS_RX_POOL_BUFFER) {
+        for (size_t i = 0; i < WS_RX_POOL_BUFFERS; i++) {
+            if (!ws_rx_pool_used[i]) {
+                ws_rx_pool_used[i] = true;
+                client->rx = ws_rx_pool[i];
+                client->rx_cap = WS_RX_POOL_BUFFER;
+                return true;
+            }
+        }
+    }
+    size_t cap = client->rx_cap * 2 > needed ? client->rx_cap * 2 : needed;
+    if (cap > WS_RX_MAX_MESSAGE) cap = WS_RX_MAX_MESSAGE;
+    uint8_t* data = heap_caps_malloc(cap, MALLOC_CAP_SPIRAM);
+    if (!data) return false;
+    if (client->rx_len) memcpy(data, client->rx, client->rx_len);
+    size_t len = client->rx_len;
+    httpd_ws_type_t type = client->rx_type;
+    ws_rx_release(client);
+    client->rx = data;
+    client->rx_len = len;
+    client->rx_cap = cap;
+    client->rx_type = type;
+    return true;
+}
+
+static void ws_client_free(void* ctx) {
+    ws_client_t* client = (ws_client_t*)ctx;
+    while (client->depth > 0) ws_client_pop(client);
+    ws_rx_release(client);
+    free(client);
+}
+
+static esp_err_t ws_client_send(ws_client_t* client, const ws_message_t* msg) {
+    int64_t start = jw_metrics_start();
+    esp_err_t err;
+    if (client->encoding == WS_ENCODING_SSE) err = httpd_resp_send_chunk(client->sse, msg->sse, msg->sse_len);
+    else if (client->encoding == WS_ENCODING_CBOR) err = jw_server_core_send_ws_binary(ws_server, client->fd, msg->cbor, msg->cbor_len);
+    else err = jw_server_core_send_ws_text(ws_server, client->fd, msg->text, msg->text_len);
+    jw_metrics_observe_since(&ws_send_seconds, start);
+    return err;
+}
+
+// Send failed, the client is unregistered (and an /events client freed) once the server closed the session
+static void ws_client_fail(ws_client_t* client) {
+    client->closing = true;
+    while (client->depth > 0) ws_client_pop(client);
+    if (client->sse) httpd_req_async_handler_complete(client->sse); // Hands the socket back so it can be closed
+    httpd_sess_trigger_close(ws_server, client->fd);
+}
+
+// Room in the socket send buffer, so the send doesn't stall the server task on a client that stopped reading
+static bool ws_client_writable(int fd) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(fd, &fds);
+    struct timeval no_wait = { 0 };
+    return select(fd + 1, NULL, &fds, NULL, &no_wait) > 0;
+}
+
+// Sends what the clients' sockets take right now, whatever is left is retried by ws_flush_timer
+static void ws_flush(void) {
+    bool pending = false;
+    for (size_t i = 0; i < CONFIG_LWIP_MAX_SOCKETS; i++) {
+        ws_client_t* client = ws_clients[i];
+        if (!client) continue;
+        while (client->depth > 0 && ws_client_writable(client->fd)) {
+            if (ws_client_send(client, ws_client_slot(client, 0)->msg) != ESP_OK) {
+                ws_client_fail(client);
+                break;
+            }
+            ws_client_pop(client);
+            client->sent++;
+        }
+        if (client->depth > 0) pending = true;
+    }
+    if (pending && ws_flush_timer && !esp_timer_is_active(ws_flush_timer)) esp_timer_start_once(ws_flush_timer, WS_FLUSH_RETRY_US);
+}
+
+static void ws_flush_work(void* arg) {
+    ws_flush();
+}
+
+// httpd_queue_work from another task, false once jw_server_ws_stop has begun, httpd_stop frees the handle after it
+static bool ws_queue_work(httpd_work_fn_t work, void* arg) {
+    if (!ws_queue_lock) return false;
+    xSemaphoreTake(ws_queue_lock, portMAX_DELAY);
+    bool queued = ws_queue_server && httpd_queue_work(ws_queue_server, work, arg) == ESP_OK;
+    xSemaphoreGive(ws_queue_lock);
+    return queued;
+}
+
+static void ws_flush_timer_cb(void* arg) {
+    ws_queue_work(ws_flush_work, NULL);
+}
+
+// An idle event stream gets a comment line, which is also how a client that went away is noticed: nothing is
+// read from the socket while the request is held open
+static void ws_ping_work(void* arg) {
+    for (size_t i = 0; i < CONFIG_LWIP_MAX_SOCKETS; i++) {
+        ws_client_t* client = ws_clients[i];
+        if (!client || !client->sse || client->closing || client->depth > 0 || !ws_client_writable(client->fd)) continue;
+        if (httpd_resp_send_chunk(client->sse, ": ping\n\n", 8) != ESP_OK) ws_client_fail(client);
+    }
+}
+
+static void ws_ping_timer_cb(void* arg) {
+    ws_queue_work(ws_ping_work, NULL);
+}
+
+// Kept with its topic for /events clients that reconnect with the id of the last event they saw
+static void ws_event_record(ws_message_t* msg, const ws_publish_t* publish) {
+    if (!ws_message_render(msg, WS_ENCODING_SSE)) return;
+    ws_event_t* event = &ws_events[ws_events_next];
+    ws_message_unref(event->msg);
+    msg->refs++;
+    event->msg = msg;
+    memcpy(event->topic, publish->topic, sizeof(event->topic));
+    memcpy(event->key, publish->key, sizeof(event->key));
+    ws_events_next = (ws_events_next + 1) % WS_EVENT_HISTORY;
+}
+
+// Queues the recorded events after last_id that the client's subscriptions match, oldest first
+static void ws_event_replay(ws_client_t* client, uint32_t last_id) {
+    if (last_id > ws_event_id) last_id = 0; // Id from before a restart, everything still recorded is news
+    for (size_t i = 0; i < WS_EVENT_HISTORY; i++) {
+        ws_event_t* event = &ws_events[(ws_events_next + i) % WS_EVENT_HISTORY];
+        ws_client_set_t matched;
+        if (!event->msg || event->msg->id <= last_id) continue;
+        ws_topic_subscribers(event->topic, matched);
+        if (ws_set_has(matched, client->slot)) ws_client_push(client, event->msg, event->key);
+    }
+}
+
+static void ws_publish_work(void* arg) {
+    ws_publish_t* publish = (ws_publish_t*)arg;
+    ws_client_set_t matched;
+    ws_topic_subscribers(publish->topic, matched);
+    ws_message_t* msg = ws_message_new(publish->json);
+    for (size_t i = 0; msg && i < CONFIG_LWIP_MAX_SOCKETS; i++) {
+        ws_client_t* client = ws_clients[i];
+        if (client && ws_set_has(matched, i) && ws_message_render(msg, client->encoding)) ws_client_push(client, msg, publish->key);
+    }
+    if (msg) ws_event_record(msg, publish); // Even without subscribers, a reconnecting /events client may want it
+    ws_message_done(msg);
+    free(publish);
+    ws_flush();
+}
+
+static void ws_subscribe(ws_client_t* client, const char* filter, bool subscribe) {
+    if (!ws_topic_valid(filter, true)) {
+        jw_log_msg("WS topic rejected");
+        return;
+    }
+    ws_client_set_t peers;
+    ws_topic_subscribers(WS_PEERS_TOPIC, peers);
+    bool had_peers = ws_set_has(peers, client->slot);
+    if (subscribe) {
+        uint8_t node = ws_topic_find(filter, true);
+        if (!node) {
+            jw_log_msg("WS topic table full");
+            return;
+        }
+        ws_set_add(ws_topics[node].subscribers, client->slot);
+    } else {
+        uint8_t node = ws_topic_find(filter, false);
+        if (node) ws_set_remove(ws_topics[node].subscribers, client->slot);
+        ws_topic_prune(0);
+    }
+    ws_topic_subscribers(WS_PEERS_TOPIC, peers);
+    if (!had_peers && ws_set_has(peers, client->slot)) ws_peers_sync(client); // Full table now, patches from then on
+}
+
+static void ws_run_command(ws_client_t* client, const ws_command_t* cmd) {
+    if (cmd->type == 9 && strcmp(cmd->key, "confirm_peer") == 0) {
+        jw_peers_add(cmd->val);
+        jw_espnow_peer(cmd->val);
+    } else if (cmd->type == WS_CMD_SUBSCRIBE && strcmp(cmd->key, "subscribe") == 0) {
+        ws_subscribe(client, cmd->val, true);
+    } else if (cmd->type == WS_CMD_SUBSCRIBE && strcmp(cmd->key, "unsubscribe") == 0) {
+        ws_subscribe(client, cmd->val, false);
+    }
+}
+
+// One command object, or an array of them from the UI batching several changes into one message.
+// Text or CBOR, depending on the frame type the message started with
+static void ws_handle_message(ws_client_t* client, const uint8_t* data, size_t len, bool binary) {
+    ws_command_t cmd = {0};
+    const char* field = NULL;
+    size_t start = 0;
+    while (!binary && start < len && (data[start] == ' ' || data[start] == '\t' || data[start] == '\r' || data[start] == '\n')) start++;
+    if (!binary && start < len && data[start] == '{') {
+        // Decoded straight into cmd, missing or mistyped fields are rejected instead of dereferencing NULL
+        if (cJSON_BindDecode(ws_command_fields, sizeof(ws_command_fields) / sizeof(ws_command_fields[0]), &cmd,
+                (const char*)data, len, &field) != cJSON_BindOk) {
+            jw_log_msg("WS command rejected");
+            return;
+        }
+        ws_run_command(client, &cmd);
+        return;
+    }
+    cJSON* json = NULL;
+    bool in_arena = false;
+    if (binary) {
+        json = cJSON_ParseCbor(data, len);
+    } else {
+        jw_server_core_parse_json_arena((const char*)data, len, &ws_cmd_arena, &json); // Server task only, one arena does
+        in_arena = json != NULL;
+        if (!json) json = cJSON_ParseWithLength((const char*)data, len); // Too big for the arena, or not JSON at all
+    }
+    const cJSON* item = cJSON_IsArray(json) ? json->child : json;
+    if (!item) jw_log_msg("WS message rejected");
+    for (; item; item = cJSON_IsArray(json) ? item->next : NULL) {
+        memset(&cmd, 0, sizeof(cmd));
+        if (cJSON_BindDecodeItem(ws_command_fields, sizeof(ws_command_fields) / sizeof(ws_command_fields[0]), &cmd, item, &field) != cJSON_BindOk) {
+            jw_log_msg("WS command rejected");
+            continue; // The rest of a batch still runs
+        }
+        ws_run_command(client, &cmd);
+    }
+    if (!in_arena) cJSON_Delete(json); // An arena tree is dropped by the next reset
+}
+
+// Header first for the payload size, then the payload appended to the client's message buffer. Fragmented messages
+// arrive as one call per frame, the message is handled once the final frame is in. An error closes the session
+static esp_err_t ws_receive(httpd_req_t* req, ws_client_t* client) {
+    httpd_ws_frame_t frame = { 0 };
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK) {
+        ws_rx_release(client);
+        return err;
+    }
+    if (frame.type == HTTPD_WS_TYPE_TEXT || frame.type == HTTPD_WS_TYPE_BINARY) {
+        ws_rx_release(client); // A new message, whatever was pending is incomplete
+        client->rx_type = frame.type;
+    } else if (frame.type != HTTPD_WS_TYPE_CONTINUE || client->rx_type == HTTPD_WS_TYPE_CONTINUE) {
+        jw_log_msg("WS continuation without a message"); // Protocol error, and its payload is still unread
+        ws_rx_release(client);
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Unread payload would be parsed as the next frame header, a frame that can't be taken ends the connection
+    if (!ws_rx_reserve(client, client->rx_len + frame.len)) {
+        jw_log_msg("WS message too large");
+        ws_rx_release(client);
+        return client->rx_len + frame.len > WS_RX_MAX_MESSAGE ? ESP_ERR_INVALID_SIZE : ESP_ERR_NO_MEM;
+    }
+    if (frame.len > 0) {
+        frame.payload = client->rx + client->rx_len;
+        err = httpd_ws_recv_frame(req, &frame, frame.len);
+        if (err != ESP_OK) {
+            ws_rx_release(client);
+            return err;
+        }
+        client->rx_len += frame.len;
+    }
+    if (!frame.final) return ESP_OK;
+    ws_handle_message(client, client->rx, client->rx_len, client->rx_type == HTTPD_WS_TYPE_BINARY);
+    ws_rx_release(client);
+    return ESP_OK;
+}
+
+static esp_err_t ws_handle_request(httpd_req_t* req) {
     if (req->method == HTTP_GET) {
+        const ws_endpoint_t* endpoint = ws_endpoint_find(req->uri);
+        size_t slot = 0;
+        while (slot < CONFIG_LWIP_MAX_SOCKETS && ws_clients[slot]) slot++;
+        if (!endpoint || slot == CONFIG_LWIP_MAX_SOCKETS) return ESP_FAIL;
+        ws_client_t* client = calloc(1, sizeof(ws_client_t));
+        if (!client) return ESP_ERR_NO_MEM;
+        char query[32];
+        char format[8];
+        client->fd = httpd_req_to_sockfd(req);
+        client->slot = slot;
+        client->uri = endpoint->uri;
+        client->rx_type = HTTPD_WS_TYPE_CONTINUE;
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+            httpd_query_key_value(query, "format", format, sizeof(format)) == ESP_OK && strcmp(format, "cbor") == 0) {
+            client->encoding = WS_ENCODING_CBOR;
+        }
+        // Through the request, a ctx set with httpd_sess_set_ctx here would be freed when the request is cleaned up
+        req->sess_ctx = client;
+        req->free_ctx = ws_client_free;
+        ws_clients[slot] = client;
+        if (endpoint->topic) ws_subscribe(client, endpoint->topic, true);
         jw_keep_alive_add(req);
-        return;
+        return ESP_OK;
     }
-    uint8_t buf[256] = {0};
-    int ret = httpd_ws_recv_frame(req, buf, sizeof(buf));
-    if (ret >= 0) {
-        cJSON* json = NULL;
-        jw_server_core_parse_json((char*)buf, &json);
-        if (json) {
-            int type = cJSON_GetObjectItem(json, "type")->valueint;
-            const char* key = cJSON_GetObjectItem(json, "key")->valuestring;
-            const char* val = cJSON_GetObjectItem(json, "val")->valuestring;
-            if (type == 9 && strcmp(key, "confirm_peer") == 0) {
-                jw_peers_add(val);
-                jw_espnow_peer(val);
-            }
-            cJSON_Delete(json);
+    if (!req->sess_ctx) return ESP_FAIL; // Handshake wasn't registered, the session has nothing to receive into
+    return ws_receive(req, (ws_client_t*)req->sess_ctx);
+}
+
+static esp_err_t ws_handler(httpd_req_t* req) {
+    int64_t start = jw_metrics_start();
+    esp_err_t err = ws_handle_request(req);
+    jw_metrics_observe_since(&ws_handler_seconds, start);
+    return err;
+}
+
+// GET /api/ws/clients: [{"fd":54,"uri":"/ws","topics":["peers"],"depth":0,"sent":12,"dropped":0,"coalesced":3}]
+static esp_err_t ws_clients_handler(httpd_req_t* req) {
+    cJSON* list = cJSON_CreateArray();
+    char path[WS_TOPIC_LEN];
+    for (size_t i = 0; i < CONFIG_LWIP_MAX_SOCKETS; i++) {
+        const ws_client_t* client = ws_clients[i];
+        if (!client) continue;
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "fd", client->fd);
+        cJSON_AddStringToObject(item, "uri", client->uri);
+        ws_topic_list(0, path, 0, client->slot, cJSON_AddArrayToObject(item, "topics"));
+        cJSON_AddNumberToObject(item, "depth", client->depth);
+        cJSON_AddNumberToObject(item, "sent", client->sent);
+        cJSON_AddNumberToObject(item, "dropped", client->dropped);
+        cJSON_AddNumberToObject(item, "coalesced", client->coalesced);
+        cJSON_AddItemToArray(list, item);
+    }
+    esp_err_t err = jw_server_core_send_json_chunked(req, list);
+    cJSON_Delete(list);
+    return err;
+}
+
+// GET /api/peers: {"peers":{<mac>:{...}},"blacklist":["aa:bb:cc:dd:ee:ff"]}, the table as in the WS "peers" message.
+// Pollers send the ETag back in If-None-Match and get a 304, without anything being built, until either changes
+static esp_err_t peers_handler(httpd_req_t* req) {
+    char etag[JW_SERVER_CORE_ETAG_LEN];
+    uint32_t generations[] = { jw_peers_get_generation(), jw_peers_get_blacklist_generation() };
+    jw_server_core_etag(etag, sizeof(etag), generations, sizeof(generations) / sizeof(generations[0]));
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (jw_server_core_not_modified(req, etag)) return ESP_OK;
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddItemToObject(json, "peers", ws_build_peers_json());
+    cJSON* list = cJSON_AddArrayToObject(json, "blacklist");
+    uint8_t blacklist[JW_PEERS_BLACKLIST_MAX_SIZE][ESP_NOW_ETH_ALEN];
+    uint8_t count = 0;
+    if (jw_peers_get_blacklist(blacklist, &count) != ESP_OK) count = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        char mac_str[18];
+        snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(blacklist[i]));
+        cJSON_AddItemToArray(list, cJSON_CreateString(mac_str));
+    }
+    esp_err_t err = jw_server_core_send_json_chunked(req, json);
+    cJSON_Delete(json);
+    return err;
+}
+
+// %XX escapes in place, "#" can't appear in a URL otherwise
+static void ws_query_unescape(char* value) {
+    char* out = value;
+    for (const char* in = value; *in; out++) {
+        unsigned byte;
+        if (in[0] == '%' && isxdigit((unsigned char)in[1]) && isxdigit((unsigned char)in[2]) && sscanf(in + 1, "%2x", &byte) == 1) {
+            *out = (char)byte;
+            in += 3;
+        } else {
+            *out = *in++;
         }
     }
+    *out = '\0';
+}
+
+// GET /events?topics=peers,telemetry/%23: the same messages WS clients get, as a text/event-stream. The request is
+// held open with httpd_req_async_handler_begin and fed from the server task like a WS client's queue
+static esp_err_t sse_handler(httpd_req_t* req) {
+    size_t slot = 0;
+    while (slot < CONFIG_LWIP_MAX_SOCKETS && ws_clients[slot]) slot++;
+    if (slot == CONFIG_LWIP_MAX_SOCKETS) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "5");
+        return httpd_resp_send(req, NULL, 0);
+    }
+    char query[128];
+    char topics[WS_TOPIC_LEN * 2] = WS_SSE_TOPICS;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "topics", topics, sizeof(topics));
+        ws_query_unescape(topics);
+    }
+    char last_id[12];
+    uint32_t resume = 0; // Sent by EventSource when it reconnects
+    bool resuming = httpd_req_get_hdr_value_str(req, "Last-Event-ID", last_id, sizeof(last_id)) == ESP_OK;
+    if (resuming) resume = strtoul(last_id, NULL, 10);
+
+    ws_client_t* client = calloc(1, sizeof(ws_client_t));
+    if (!client || httpd_req_async_handler_begin(req, &client->sse) != ESP_OK) {
+        free(client);
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+    }
+    client->fd = httpd_req_to_sockfd(client->sse);
+    client->slot = slot;
+    client->uri = "/events";
+    client->encoding = WS_ENCODING_SSE;
+    httpd_resp_set_type(client->sse, "text/event-stream");
+    httpd_resp_set_hdr(client->sse, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(client->sse, "X-Accel-Buffering", "no"); // Proxies pass events on instead of collecting them
+    if (httpd_resp_send_chunk(client->sse, "retry: 5000\n\n", 13) != ESP_OK) {
+        httpd_req_async_handler_complete(client->sse);
+        free(client);
+        return ESP_OK; // Nothing more can be sent on the socket
+    }
+    ws_clients[slot] = client;
+    char* next = NULL;
+    for (char* filter = strtok_r(topics, ",", &next); filter; filter = strtok_r(NULL, ",", &next)) ws_subscribe(client, filter, true);
+    if (resuming) ws_event_replay(client, resume);
+    ws_flush();
+    return ESP_OK;
 }
 
 void jw_server_ws_start(httpd_handle_t server) {
-    httpd_uri_t ws = { .uri = "/ws", .method = HTTP_GET, .handler = ws_handler, .is_websocket = true };
-    httpd_uri_t ws_nodes = { .uri = "/ws/nodes", .method = HTTP_GET, .handler = ws_handler, .is_websocket = true };
-    httpd_uri_t ws_peers = { .uri = "/ws/peers", .method = HTTP_GET, .handler = ws_handler, .is_websocket = true };
-    httpd_register_uri_handler(server, &ws);
-    httpd_register_uri_handler(server, &ws_nodes);
-    httpd_register_uri_handler(server, &ws_peers);
+    if (!ws_queue_lock) ws_queue_lock = xSemaphoreCreateMutex();
+    if (!ws_queue_lock) {
+        jw_log_msg("WebSocket lock allocation failed");
+        return;
+    }
+    cJSON_InitArena(&ws_cmd_arena, ws_cmd_arena_buf, sizeof(ws_cmd_arena_buf));
+    ws_server = server;
+    xSemaphoreTake(ws_queue_lock, portMAX_DELAY);
+    ws_queue_server = server;
+    xSemaphoreGive(ws_queue_lock);
+    jw_metrics_register(&ws_handler_seconds);
+    jw_metrics_register(&ws_send_seconds);
+    for (size_t i = 0; i < WS_ENDPOINT_COUNT; i++) {
+        httpd_uri_t ws = { .uri = ws_endpoints[i].uri, .method = HTTP_GET, .handler = ws_handler, .is_websocket = true };
+        httpd_register_uri_handler(server, &ws);
+    }
+    httpd_uri_t clients = { .uri = "/api/ws/clients", .method = HTTP_GET, .handler = ws_clients_handler };
+    httpd_uri_t events = { .uri = "/events", .method = HTTP_GET, .handler = sse_handler };
+    httpd_uri_t peers = { .uri = "/api/peers", .method = HTTP_GET, .handler = peers_handler }; // "/api/peers/*" doesn't match it
+    httpd_register_uri_handler(server, &clients);
+    httpd_register_uri_handler(server, &peers);
+    httpd_register_uri_handler(server, &events);
+    if (!ws_flush_timer) {
+        esp_timer_create_args_t timer = { .callback = ws_flush_timer_cb, .name = "ws_flush" };
+        esp_timer_create(&timer, &ws_flush_timer);
+    }
+    if (!ws_ping_timer) {
+        esp_timer_create_args_t timer = { .callback = ws_ping_timer_cb, .name = "ws_ping" };
+        esp_timer_create(&timer, &ws_ping_timer);
+    }
+    if (ws_ping_timer) esp_timer_start_periodic(ws_ping_timer, WS_SSE_PING_US);
     jw_log_msg("WebSocket endpoints registered");
 }
 
+// Server task side of jw_server_ws_stop, runs after the work queued before ws_queue_server was cleared. The timers
+// go here as well, ws_flush reads ws_flush_timer from this task
+static void ws_teardown(void) {
+    if (ws_flush_timer) {
+        esp_timer_stop(ws_flush_timer);
+        esp_timer_delete(ws_flush_timer);
+        ws_flush_timer = NULL;
+    }
+    if (ws_ping_timer) {
+        esp_timer_stop(ws_ping_timer);
+        esp_timer_delete(ws_ping_timer);
+        ws_ping_timer = NULL;
+    }
+    cJSON_Delete(ws_peers_snapshot);
+    ws_peers_snapshot = NULL;
+    for (size_t i = 0; i < CONFIG_LWIP_MAX_SOCKETS; i++) {
+        ws_client_t* client = ws_clients[i];
+        if (!client || !client->sse) continue; // The server frees WS clients with the sessions
+        if (!client->closing) httpd_req_async_handler_complete(client->sse);
+        ws_client_free(client);
+    }
+    for (size_t i = 0; i < WS_EVENT_HISTORY; i++) ws_message_unref(ws_events[i].msg);
+    memset(ws_events, 0, sizeof(ws_events));
+    memset(ws_clients, 0, sizeof(ws_clients));
+    memset(ws_topics, 0, sizeof(ws_topics));
+    ws_server = NULL;
+}
+
+static void ws_teardown_work(void* arg) {
+    ws_teardown();
+    xSemaphoreGive((SemaphoreHandle_t)arg);
+}
+
+// Runs in the Wi-Fi event task right before httpd_stop. Nothing is queued on the server from here on, and the
+// registry is torn down by the server task so no handler or work item sees it half cleared
 void jw_server_ws_stop(void) {
     jw_keep_alive_clear();
+    if (!ws_queue_lock) return;
+    xSemaphoreTake(ws_queue_lock, portMAX_DELAY);
+    httpd_handle_t server = ws_queue_server;
+    ws_queue_server = NULL;
+    xSemaphoreGive(ws_queue_lock);
+    if (!server) return;
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    if (done && httpd_queue_work(server, ws_teardown_work, done) == ESP_OK) {
+        if (xSemaphoreTake(done, pdMS_TO_TICKS(WS_STOP_TIMEOUT_MS)) != pdTRUE) {
+            jw_log_msg("WebSocket teardown timed out");
+            return; // done is still given by the queued item, leaked instead of deleted under it
+        }
+    } else {
+        ws_teardown(); // The server task isn't taking work, nothing else touches the registry
+    }
+    if (done) vSemaphoreDelete(done);
 }
 
-void jw_server_ws_send_peers_update(void) {
+void jw_server_ws_client_closed(int fd) {
+    for (size_t i = 0; i < CONFIG_LWIP_MAX_SOCKETS; i++) {
+        ws_client_t* client = ws_clients[i];
+        if (!client || client->fd != fd) continue;
+        ws_topic_remove_client(i);
+        ws_clients[i] = NULL;
+        if (client->sse) ws_client_free(client); // No session context owns an /events client
+    }
+}
+
+esp_err_t jw_server_ws_publish(const char* topic, const char* key, cJSON* json) {
+    ws_publish_t* publish = malloc(sizeof(ws_publish_t));
+    if (!publish || strlen(topic) >= WS_TOPIC_LEN || !ws_topic_valid(topic, false)) {
+        free(publish);
+        cJSON_Delete(json);
+        return ESP_ERR_INVALID_STATE;
+    }
+    strcpy(publish->topic, topic);
+    snprintf(publish->key, sizeof(publish->key), "%s", key ? key : "");
+    publish->json = json;
+    // Matched, serialized and queued from the server task, the caller never waits on a socket
+    if (!ws_queue_work(ws_publish_work, publish)) {
+        jw_log_msg("WS publish dropped");
+        free(publish);
+        cJSON_Delete(json);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// Keyed by MAC so a merge patch only carries the peers and fields that changed. The diff looks every MAC up in the
+// snapshot and the new table, indexed once the table is big enough for that to beat walking the list
+static cJSON* ws_build_peers_json(void) {
+    cJSON* table = cJSON_CreateObject();
+    cJSON_EnableObjectIndex(table);
+    jw_peer_entry_t* peers = NULL;
+    uint8_t peer_count = 0;
+    if (jw_peers_get_peer(&peers, &peer_count) != ESP_OK) return table;
+    for (uint8_t i = 0; i < peer_count; i++) {
+        char mac_str[18];
+        snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(peers[i].mac_address));
+        cJSON* peer = cJSON_CreateObject();
+        cJSON_AddStringToObject(peer, "mac", mac_str);
+        cJSON_AddStringToObject(peer, "name", peers[i].peer_name);
+        cJSON_AddNumberToObject(peer, "type", peers[i].peer_type);
+        cJSON_AddBoolToObject(peer, "active", peers[i].is_active);
+        cJSON_AddNumberToObject(peer, "interval", peers[i].data_interval_sec);
+        cJSON_AddNumberToObject(peer, "last_update", peers[i].last_update);
+        cJSON* values = cJSON_CreateFloatArray(peers[i].latest_data.sensor_values, peers[i].sensor_count);
+        cJSON_SetNumberPrecision(values, 2); // Sensor floats, 21.30 instead of 21.299999237060547
+        cJSON_AddItemToObject(peer, "values", values);
+        cJSON_AddItemToObject(table, mac_str, peer);
+    }
+    return table;
+}
+
+static cJSON* ws_build_peers_message(const char* key, cJSON* val) {
     cJSON* json = cJSON_CreateObject();
     cJSON_AddNumberToObject(json, "type", 1);
-    cJSON_AddStringToObject(json, "key", "peers");
-    char* peers = jw_peers_get_all();
-    cJSON_AddStringToObject(json, "val", peers);
-    char* rendered = cJSON_PrintUnformatted(json);
-    httpd_ws_send_frame_to_clients("/ws/peers", rendered, strlen(rendered));
-    free(rendered);
-    cJSON_Delete(json);
+    cJSON_AddStringToObject(json, "key", key);
+    cJSON_AddItemReferenceToObject(json, "val", val); // val stays owned by the caller
+    return json;
+}
+
+// A client that just subscribed gets the table as last sent to the others, so the next patch applies to it as well
+static void ws_peers_sync(ws_client_t* client) {
+    client->synced = false;
+    if (!ws_peers_snapshot) return; // No update yet, the first one is sent in full
+    ws_message_t* msg = ws_message_new(ws_build_peers_message("peers", ws_peers_snapshot));
+    client->synced = msg && ws_message_render(msg, client->encoding);
+    if (client->synced) ws_client_push(client, msg, WS_PEERS_KEY);
+    ws_message_done(msg);
+    ws_flush();
+}
+
+// Server task side of jw_server_ws_send_peers_update, arg is the freshly built table
+static void ws_peers_work(void* arg) {
+    cJSON* peers = (cJSON*)arg;
+    ws_client_set_t matched;
+    ws_topic_subscribers(WS_PEERS_TOPIC, matched);
+    cJSON* patch = ws_peers_snapshot ? cJSON_CreateMergePatch(ws_peers_snapshot, peers) : NULL;
+    ws_message_t* full = NULL;  // {"type":1,"key":"peers","val":{<mac>:{...}}} for clients without the snapshot
+    ws_message_t* delta = NULL; // {"type":1,"key":"peers_patch","val":<RFC 7386 patch>} for the others
+    for (size_t i = 0; i < CONFIG_LWIP_MAX_SOCKETS; i++) {
+        ws_client_t* client = ws_clients[i];
+        if (!client || !ws_set_has(matched, i)) continue;
+        // A patch can't replace one still queued (the older changes would be lost), the full table can
+        bool needs_full = !patch || !client->synced || ws_client_has_queued(client, WS_PEERS_KEY);
+        if (!needs_full && !patch->child) continue; // Nothing changed
+        ws_message_t** msg = needs_full ? &full : &delta;
+        if (!*msg) *msg = ws_message_new(ws_build_peers_message(needs_full ? "peers" : "peers_patch", needs_full ? peers : patch));
+        client->synced = *msg && ws_message_render(*msg, client->encoding);
+        if (client->synced) ws_client_push(client, *msg, WS_PEERS_KEY);
+    }
+    ws_message_done(full);
+    ws_message_done(delta);
+    cJSON_Delete(patch);
+    cJSON_Delete(ws_peers_snapshot);
+    ws_peers_snapshot = peers;
+    ws_flush();
+}
+
+void jw_server_ws_send_peers_update(void) {
+    if (!ws_queue_server) return; // Unlocked early out, ws_queue_work checks again
+    cJSON* peers = ws_build_peers_json(); // Read in the caller's task, diffed and queued in the server task
+    if (!ws_queue_work(ws_peers_work, peers)) {
+        jw_log_msg("WS peers update dropped");
+        cJSON_Delete(peers);
+    }
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #include "jw_wifi.h"
 #include <esp_log.h>
 #include <esp_event.h>
-#include <nvs_flash.h>
 #include <string.h>
 #include <stdbool.h>
 
@@ -14,6 +13,8 @@ static SemaphoreHandle_t jw_wifi_settings_mutex;
 static jw_wifi_settings_t jw_wifi_settings = { 0 };
 /** @brief Flag indicating settings need applying */
 static bool jw_wifi_settings_dirty = false;
+/** @brief Incremented by every settings change, see jw_wifi_get_generation */
+static uint32_t jw_wifi_settings_generation = 0;
 /** @brief Event group for Wi-Fi events */
 static EventGroupHandle_t jw_wifi_event_group;
 /** @brief Server interface for Wi-Fi module */
@@ -44,6 +45,7 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t e
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
         jw_wifi_settings.sta.ip = event->ip_info.ip;
+        jw_wifi_settings_generation++;
         ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
         xEventGroupSetBits(jw_wifi_event_group, JW_WIFI_GOT_IP_BIT);
     }
@@ -212,37 +214,35 @@ esp_err_t jw_wifi_apply(void) {
 }
 
 /**
- * @brief Save Wi-Fi configuration to NVS
+ * @brief Get current Wi-Fi settings
  */
-esp_err_t jw_wifi_save_config(const char *key, const char *value) {
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open("wifi_config", NVS_READWRITE, &nvs_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
-        return err;
-    }
-
-    err = nvs_set_str(nvs_handle, key, value);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set NVS value for %s: %s", key, esp_err_to_name(err));
-        nvs_close(nvs_handle);
-        return err;
-    }
+jw_wifi_settings_t *jw_wifi_get_settings(void) {
+    return &jw_wifi_settings;
+}
 
-    err = nvs_commit(nvs_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(err));
+/**
+ * @brief Replace the Wi-Fi settings in one step
+ */
+esp_err_t jw_wifi_set_settings(const jw_wifi_settings_t *settings) {
+    if (!settings || settings->mode > JW_WIFI_MODE_APSTA) {
+        ESP_LOGE(TAG, "Invalid settings");
+        return ESP_ERR_INVALID_ARG;
     }
-
-    nvs_close(nvs_handle);
-    return err;
+    xSemaphoreTake(jw_wifi_settings_mutex, portMAX_DELAY);
+    esp_ip4_addr_t ip = jw_wifi_settings.sta.ip;
+    jw_wifi_settings = *settings;
+    jw_wifi_settings.sta.ip = ip; // Owned by the IP event
+    jw_wifi_settings_dirty = true;
+    jw_wifi_settings_generation++;
+    xSemaphoreGive(jw_wifi_settings_mutex);
+    return ESP_OK;
 }
 
 /**
- * @brief Get current Wi-Fi settings
+ * @brief Get the settings generation
  */
-jw_wifi_settings_t *jw_wifi_get_settings(void) {
-    return &jw_wifi_settings;
+uint32_t jw_wifi_get_generation(void) {
+    return jw_wifi_settings_generation;
 }
 
 /**
@@ -275,6 +275,7 @@ esp_err_t jw_wifi_set_mode(jw_wifi_user_mode_t mode) {
 
     jw_wifi_settings.mode = mode;
     jw_wifi_settings_dirty = true;
+    jw_wifi_settings_generation++;
 
     if (wifi_server_if) {
         if (mode == JW_WIFI_MODE_NO_WIFI) {
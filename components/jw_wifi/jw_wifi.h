@@ -70,20 +70,29 @@ esp_err_t jw_wifi_start(void);
  */
 esp_err_t jw_wifi_apply(void);
 
-/**
- * @brief Save Wi-Fi configuration to NVS
- * @param key NVS key for the setting
- * @param value Value to save
- * @return esp_err_t ESP_OK on success, ESP_FAIL on failure
- */
-esp_err_t jw_wifi_save_config(const char *key, const char *value);
-
 /**
  * @brief Get current Wi-Fi settings
  * @return jw_wifi_settings_t* Pointer to current settings
  */
 jw_wifi_settings_t *jw_wifi_get_settings(void);
 
+/**
+ * @brief Replace the Wi-Fi settings in one step
+ * @param settings New mode, channel, country and credentials, the station IP is kept
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG on failure
+ *
+ * Nothing is applied to the radio, call jw_wifi_apply once the change should take effect.
+ */
+esp_err_t jw_wifi_set_settings(const jw_wifi_settings_t *settings);
+
+/**
+ * @brief Get the settings generation
+ * @return uint32_t Counter incremented by every change of the settings, station IP included
+ *
+ * Equal values mean unchanged settings since boot, e.g. for an HTTP ETag.
+ */
+uint32_t jw_wifi_get_generation(void);
+
 /**
  * @brief Get Wi-Fi event group
  * @return EventGroupHandle_t Handle to Wi-Fi event group
@@ -0,0 +1,127 @@
+#include "bench.h"
+#include "cJSON.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static size_t bench_allocs = 0;
+static size_t bench_bytes = 0;
+
+uint64_t bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+double bench_ns_per_run(bench_fn fn, void* arg) {
+    fn(arg); // Warm up caches and the allocator
+    uint64_t runs = 1; // Per batch, grown until a batch takes BENCH_BATCH_NS
+    uint64_t start = bench_now_ns();
+    double best = 0;
+    for (;;) {
+        uint64_t batch_start = bench_now_ns();
+        for (uint64_t i = 0; i < runs; i++) fn(arg);
+        uint64_t batch = bench_now_ns() - batch_start;
+        if (batch < BENCH_BATCH_NS) {
+            runs *= 2;
+            continue;
+        }
+        double ns = (double)batch / (double)runs;
+        if (best == 0 || ns < best) best = ns;
+        if (bench_now_ns() - start >= BENCH_MIN_NS) return best;
+    }
+}
+
+static void* bench_malloc(size_t size) {
+    bench_allocs++;
+    bench_bytes += size;
+    return malloc(size);
+}
+
+void bench_count_allocations(void) {
+    cJSON_Hooks hooks = { .malloc_fn = bench_malloc, .free_fn = free };
+    cJSON_InitHooks(&hooks);
+}
+
+void bench_reset_counts(void) {
+    bench_allocs = 0;
+    bench_bytes = 0;
+}
+
+size_t bench_allocations(void) {
+    return bench_allocs;
+}
+
+size_t bench_allocated_bytes(void) {
+    return bench_bytes;
+}
+
+// Appends to a growing buffer, the corpora are built once so this doesn't need to be quick
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} bench_text_t;
+
+static void bench_append(bench_text_t* text, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (text->len + n + 1 > text->cap) {
+        text->cap = (text->len + n + 1) * 2;
+        text->data = realloc(text->data, text->cap);
+        if (!text->data) abort();
+    }
+    va_start(args, format);
+    vsnprintf(text->data + text->len, n + 1, format, args);
+    va_end(args);
+    text->len += n;
+}
+
+static void bench_mac(char* mac, size_t size, unsigned peer) {
+    snprintf(mac, size, "24:6F:28:%02X:%02X:%02X", (peer >> 16) & 0xff, (peer >> 8) & 0xff, peer & 0xff);
+}
+
+char* bench_telemetry_corpus(size_t records, size_t* len) {
+    bench_text_t text = { 0 };
+    bench_append(&text, "{\"records\":[");
+    for (size_t i = 0; i < records; i++) {
+        char mac[18];
+        bench_mac(mac, sizeof(mac), (unsigned)(i % 6));
+        bench_append(&text, "%s{\"ts\":%u,\"mac\":\"%s\",\"type\":0,\"values\":[%.2f,%.2f,%.1f]}", i ? "," : "",
+                     1760644800u + (unsigned)i * 10, mac, 20.0 + (i % 50) / 10.0, 45.0 + (i % 30) / 3.0, 1013.0 + (i % 7));
+    }
+    bench_append(&text, "],\"next\":\"0000a1b20000c3d4\"}");
+    *len = text.len;
+    return text.data;
+}
+
+char* bench_peers_corpus(size_t peers, size_t* len) {
+    bench_text_t text = { 0 };
+    bench_append(&text, "{\"type\":1,\"key\":\"peers\",\"val\":{");
+    for (size_t i = 0; i < peers; i++) {
+        char mac[18];
+        bench_mac(mac, sizeof(mac), (unsigned)i);
+        bench_append(&text, "%s\"%s\":{\"mac\":\"%s\",\"name\":\"Sensor \\\"%zu\\\"\",\"type\":%zu,\"active\":%s,"
+                     "\"interval\":%zu,\"last_update\":%zu,\"values\":[%.2f,%.2f]}",
+                     i ? "," : "", mac, mac, i, i % 3, i % 4 ? "true" : "false", 10 + i % 50, 1760644800 + i, 21.3 + i % 5, 48.25);
+    }
+    bench_append(&text, "}}");
+    *len = text.len;
+    return text.data;
+}
+
+char* bench_log_corpus(size_t lines, size_t* len) {
+    bench_text_t text = { 0 };
+    for (size_t i = 0; i < lines; i++) {
+        char mac[18];
+        bench_mac(mac, sizeof(mac), (unsigned)(i % 6));
+        bench_append(&text, "2026-10-16 %02zu:%02zu:%02zu %s: %.2f,%.2f,%.1f\n", (i / 3600) % 24, (i / 60) % 60, i % 60, mac,
+                     20.0 + (i % 50) / 10.0, 45.0 + (i % 30) / 3.0, 1013.0 + (i % 7));
+    }
+    *len = text.len;
+    return text.data;
+}
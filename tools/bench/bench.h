@@ -0,0 +1,29 @@
+#ifndef JW_BENCH_H
+#define JW_BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Host micro benchmarks (tools/bench), shared timing, allocation counting and test documents
+
+#define BENCH_MIN_NS 500000000ull // Each measurement repeats until it ran this long
+#define BENCH_BATCH_NS 5000000ull // Runs timed together, the fastest batch counts: other guests on a shared host only
+                                  // ever make a batch slower
+
+typedef void (*bench_fn)(void* arg);
+
+uint64_t bench_now_ns(void);
+double bench_ns_per_run(bench_fn fn, void* arg); // Average of the fastest batch within BENCH_MIN_NS
+
+void bench_count_allocations(void); // cJSON hooks that count, cJSON falls back from realloc to malloc + copy with them
+void bench_reset_counts(void);
+size_t bench_allocations(void);     // Since the last reset
+size_t bench_allocated_bytes(void);
+
+// Documents like the ones the controller handles, malloc'ed and zero terminated, free() them
+char* bench_telemetry_corpus(size_t records, size_t* len); // History page: [{"ts":..,"mac":"..","values":[..]},..]
+char* bench_peers_corpus(size_t peers, size_t* len);       // Peer table as in the WS "peers" message, keyed by MAC
+char* bench_log_corpus(size_t lines, size_t* len);         // SD log lines, "2026-10-16 20:00:00 AA:BB:..: 21.30,.."
+
+#endif
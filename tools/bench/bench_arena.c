@@ -0,0 +1,66 @@
+#include "bench.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// cJSON_Parse + cJSON_Delete vs resetting an arena and cJSON_ParseWithArena, as ws_handle_message does for
+// text command batches. Allocations are counted through the cJSON hooks
+
+static const char arena_commands[] = // A batch as the UI sends it after connecting
+    "[{\"type\":12,\"key\":\"subscribe\",\"val\":\"peers\"},"
+    "{\"type\":12,\"key\":\"subscribe\",\"val\":\"telemetry/+\"},"
+    "{\"type\":12,\"key\":\"subscribe\",\"val\":\"logs\"},"
+    "{\"type\":9,\"key\":\"confirm_peer\",\"val\":\"24:6F:28:00:00:01\"}]";
+
+typedef struct {
+    const char* text;
+    size_t len;
+    cJSON_Arena arena;
+} arena_case_t;
+
+static void arena_heap(void* arg) {
+    arena_case_t* c = (arena_case_t*)arg;
+    cJSON* json = cJSON_ParseWithLength(c->text, c->len);
+    if (!json) abort();
+    cJSON_Delete(json);
+}
+
+static void arena_parse(void* arg) {
+    arena_case_t* c = (arena_case_t*)arg;
+    cJSON_ResetArena(&c->arena);
+    if (!cJSON_ParseWithArena(c->text, c->len, &c->arena)) abort();
+}
+
+static void arena_run(const char* name, const char* text, size_t len, size_t arena_size) {
+    arena_case_t c = { .text = text, .len = len };
+    void* buffer = malloc(arena_size);
+    if (!buffer) abort();
+    cJSON_InitArena(&c.arena, buffer, arena_size);
+
+    double heap_ns = bench_ns_per_run(arena_heap, &c);
+    double arena_ns = bench_ns_per_run(arena_parse, &c);
+    bench_count_allocations();
+    bench_reset_counts();
+    arena_heap(&c);
+    size_t heap_allocs = bench_allocations();
+    size_t heap_bytes = bench_allocated_bytes();
+    bench_reset_counts();
+    arena_parse(&c);
+    printf("%-14s %6zu bytes  heap %4zu allocations %6zu bytes %8.2f us  arena %zu allocations %6zu of %zu bytes %8.2f us\n",
+           name, len, heap_allocs, heap_bytes, heap_ns / 1e3, bench_allocations(), c.arena.used, arena_size, arena_ns / 1e3);
+    cJSON_InitHooks(NULL);
+    free(buffer);
+}
+
+int main(void) {
+    arena_run("ws-commands", arena_commands, strlen(arena_commands), 2048); // WS_CMD_ARENA
+    size_t len;
+    char* text = bench_peers_corpus(10, &len);
+    arena_run("peers-10", text, len, 16 * 1024);
+    free(text);
+    text = bench_telemetry_corpus(500, &len);
+    arena_run("telemetry-500", text, len, 512 * 1024);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "bench.h"
+#include "jw_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef BENCH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// jw_server_gzip.c against the stubs: CPU per input byte and compression ratio on the documents the server
+// sends gzip'ed. With zlib around every stream is inflated and compared to the input, and zlib's own levels
+// are timed for reference
+
+#define GZIP_FEED 512 // JW_SERVER_CORE_SEND_CHUNK, what the JSON and file handlers hand over at a time
+
+typedef struct {
+    const char* text;
+    size_t len;
+    uint8_t* out; // Collected response body
+    size_t out_len;
+    size_t out_cap;
+} gzip_case_t;
+
+static esp_err_t gzip_collect(httpd_req_t* req, const char* data, size_t len) {
+    gzip_case_t* c = (gzip_case_t*)req->user_ctx;
+    if (!data) return ESP_OK; // Terminating chunk
+    if (c->out_len + len > c->out_cap) {
+        c->out_cap = (c->out_len + len) * 2;
+        c->out = realloc(c->out, c->out_cap);
+        if (!c->out) abort();
+    }
+    memcpy(c->out + c->out_len, data, len);
+    c->out_len += len;
+    return ESP_OK;
+}
+
+static void gzip_stream(void* arg) {
+    gzip_case_t* c = (gzip_case_t*)arg;
+    httpd_req_t req = { .accept_encoding = "gzip, deflate", .send_chunk = gzip_collect, .user_ctx = c };
+    c->out_len = 0;
+    jw_server_gzip_t* gzip = jw_server_gzip_begin(&req);
+    if (!gzip) abort();
+    for (size_t i = 0; i < c->len; i += GZIP_FEED) {
+        size_t n = c->len - i < GZIP_FEED ? c->len - i : GZIP_FEED;
+        if (jw_server_gzip_send_chunk(&req, gzip, c->text + i, n) != ESP_OK) abort();
+    }
+    if (jw_server_gzip_send_chunk(&req, gzip, NULL, 0) != ESP_OK) abort();
+}
+
+#ifdef BENCH_HAVE_ZLIB
+static void gzip_verify(const char* name, const gzip_case_t* c) {
+    uint8_t* plain = malloc(c->len + 1);
+    z_stream z = { .next_in = c->out, .avail_in = (uInt)c->out_len, .next_out = plain, .avail_out = (uInt)c->len + 1 };
+    if (!plain || inflateInit2(&z, 15 + 16) != Z_OK) abort(); // 15 + 16: gzip wrapper, checks CRC and size
+    int err = inflate(&z, Z_FINISH);
+    if (err != Z_STREAM_END || z.total_out != c->len || memcmp(plain, c->text, c->len) != 0) {
+        fprintf(stderr, "%s: gzip output doesn't inflate to the input (zlib %d)\n", name, err);
+        exit(1);
+    }
+    inflateEnd(&z);
+    free(plain);
+}
+
+typedef struct {
+    const gzip_case_t* c;
+    int level;
+    uint8_t* out;
+    size_t out_cap;
+    size_t out_len;
+} zlib_case_t;
+
+static void zlib_deflate(void* arg) {
+    zlib_case_t* z = (zlib_case_t*)arg;
+    z_stream s = { 0 };
+    if (deflateInit2(&s, z->level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) abort();
+    s.next_in = (Bytef*)z->c->text;
+    s.avail_in = (uInt)z->c->len;
+    s.next_out = z->out;
+    s.avail_out = (uInt)z->out_cap;
+    if (deflate(&s, Z_FINISH) != Z_STREAM_END) abort();
+    z->out_len = s.total_out;
+    deflateEnd(&s);
+}
+
+static void zlib_run(const gzip_case_t* c, int level) {
+    zlib_case_t z = { .c = c, .level = level, .out_cap = c->len + c->len / 8 + 64 };
+    z.out = malloc(z.out_cap);
+    if (!z.out) abort();
+    double ns = bench_ns_per_run(zlib_deflate, &z);
+    printf("    zlib -%d     %6.2f ns/byte  ratio %5.3f  (~256 KB of state)\n", level, ns / c->len, (double)z.out_len / c->len);
+    free(z.out);
+}
+#endif
+
+static void gzip_run(const char* name, char* text, size_t len) {
+    gzip_case_t c = { .text = text, .len = len };
+    double ns = bench_ns_per_run(gzip_stream, &c);
+    printf("%-14s %7zu bytes\n    jw_server    %6.2f ns/byte  ratio %5.3f\n", name, len, ns / len, (double)c.out_len / len);
+#ifdef BENCH_HAVE_ZLIB
+    gzip_verify(name, &c);
+    zlib_run(&c, 1);
+    zlib_run(&c, 6);
+#endif
+    free(c.out);
+    free(text);
+}
+
+int main(void) {
+    jw_server_gzip_init();
+    size_t len;
+    char* text = bench_log_corpus(2000, &len); // An SD log file
+    gzip_run("log-2000", text, len);
+    text = bench_telemetry_corpus(500, &len); // One history page
+    gzip_run("telemetry-500", text, len);
+    text = bench_peers_corpus(10, &len); // JW_PEERS_MAX_CAPACITY
+    gzip_run("peers-10", text, len);
+#ifndef BENCH_HAVE_ZLIB
+    printf("zlib not found, output not verified\n");
+#endif
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "bench.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Member lookups on objects keyed by MAC, walking the list vs cJSON_EnableObjectIndex. Also times the first lookup
+// after a change, which rebuilds the index
+
+typedef struct {
+    cJSON* object;
+    char** keys;
+    size_t count;
+} index_case_t;
+
+static void index_lookup_all(void* arg) {
+    index_case_t* c = (index_case_t*)arg;
+    // Stride through the keys so the lookups don't follow the list order
+    for (size_t i = 0, k = 0; i < c->count; i++, k = (k + 7) % c->count) {
+        if (!cJSON_GetObjectItemCaseSensitive(c->object, c->keys[k])) abort();
+    }
+}
+
+static void index_rebuild(void* arg) {
+    index_case_t* c = (index_case_t*)arg;
+    cJSON_AddNullToObject(c->object, "x"); // Drops the index
+    cJSON_DeleteItemFromObjectCaseSensitive(c->object, "x");
+    if (!cJSON_GetObjectItemCaseSensitive(c->object, c->keys[c->count / 2])) abort();
+}
+
+static void index_run(size_t members) {
+    size_t len;
+    char* text = bench_peers_corpus(members, &len);
+    cJSON* root = cJSON_ParseWithLength(text, len);
+    free(text);
+    index_case_t c = { .object = cJSON_GetObjectItemCaseSensitive(root, "val"), .count = members };
+    c.keys = malloc(members * sizeof(char*));
+    size_t n = 0;
+    cJSON* member;
+    cJSON_ArrayForEach(member, c.object) c.keys[n++] = member->string;
+
+    double linear_ns = bench_ns_per_run(index_lookup_all, &c) / members;
+    cJSON_EnableObjectIndex(c.object);
+    double indexed_ns = bench_ns_per_run(index_lookup_all, &c) / members;
+    double rebuild_ns = bench_ns_per_run(index_rebuild, &c);
+    printf("%5zu members  linear %8.1f ns/lookup  indexed %6.1f ns/lookup  change + first lookup %9.1f ns\n", members,
+           linear_ns, indexed_ns, rebuild_ns);
+    free(c.keys);
+    cJSON_Delete(root);
+}
+
+int main(void) {
+    index_run(CJSON_OBJECT_INDEX_MIN_MEMBERS);
+    index_run(10);
+    index_run(100);
+    index_run(1000);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "bench.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Printing with the 256 byte start buffer that ensure() grows (cJSON_PrintBuffered) vs the measure pass:
+// cJSON_PrintUnformatted, and cJSON_PrintLength + cJSON_PrintPreallocated as jw_server_core_print_json does it
+
+#define PRINT_GUESS 256 // What print() started with before the measure pass
+
+static void print_buffered(void* arg) {
+    free(cJSON_PrintBuffered((const cJSON*)arg, PRINT_GUESS, false));
+}
+
+static void print_unformatted(void* arg) {
+    free(cJSON_PrintUnformatted((const cJSON*)arg));
+}
+
+static void print_measured(void* arg) {
+    cJSON* json = (cJSON*)arg;
+    size_t len = cJSON_PrintLength(json, false);
+    char* text = cJSON_malloc(len + 1); // Through the hooks so it is counted like the others
+    if (!text || !cJSON_PrintPreallocated(json, text, (int)len + 1, false)) abort();
+    cJSON_free(text);
+}
+
+typedef struct {
+    const char* name;
+    bench_fn fn;
+} print_way_t;
+
+static const print_way_t print_ways[] = {
+    { "buffered-256", print_buffered },
+    { "unformatted", print_unformatted },
+    { "length+prealloc", print_measured },
+};
+
+static void print_run(const char* name, char* text, size_t len) {
+    cJSON* json = cJSON_ParseWithLength(text, len);
+    free(text);
+    if (!json) abort();
+    for (size_t i = 0; i < sizeof(print_ways) / sizeof(print_ways[0]); i++) {
+        cJSON_InitHooks(NULL); // Time with realloc, as the firmware runs
+        double ns = bench_ns_per_run(print_ways[i].fn, json);
+        bench_count_allocations();
+        bench_reset_counts();
+        print_ways[i].fn(json);
+        printf("%-14s %7zu bytes  %-16s %3zu allocations %8zu bytes allocated  %9.1f us\n", name, len, print_ways[i].name,
+               bench_allocations(), bench_allocated_bytes(), ns / 1e3);
+    }
+    cJSON_InitHooks(NULL);
+    cJSON_Delete(json);
+}
+
+int main(void) {
+    size_t len;
+    char* text = bench_peers_corpus(10, &len); // JW_PEERS_MAX_CAPACITY
+    print_run("peers-10", text, len);
+    text = bench_telemetry_corpus(500, &len); // One history page
+    print_run("telemetry-500", text, len);
+    return 0;
+}
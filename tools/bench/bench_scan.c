@@ -0,0 +1,62 @@
+#include "bench.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Parse and print throughput of the string and whitespace scanners. Built once per scanner variant of cJSON.c
+// (BENCH_VARIANT), compare the lines of bench_scan, bench_scan_swar and bench_scan_sse2
+
+#ifndef BENCH_VARIANT
+#define BENCH_VARIANT "bytes"
+#endif
+
+typedef struct {
+    const char* text;
+    size_t len;
+    cJSON* tree;
+} scan_case_t;
+
+static void scan_parse(void* arg) {
+    scan_case_t* c = (scan_case_t*)arg;
+    cJSON_Delete(cJSON_ParseWithLength(c->text, c->len));
+}
+
+static void scan_print(void* arg) {
+    scan_case_t* c = (scan_case_t*)arg;
+    free(cJSON_PrintUnformatted(c->tree));
+}
+
+static void scan_run(const char* name, char* text, size_t len) {
+    scan_case_t c = { .text = text, .len = len, .tree = cJSON_ParseWithLength(text, len) };
+    if (!c.tree) {
+        fprintf(stderr, "%s: corpus doesn't parse\n", name);
+        exit(1);
+    }
+    double parse_ns = bench_ns_per_run(scan_parse, &c);
+    double print_ns = bench_ns_per_run(scan_print, &c);
+    printf("%-8s %-14s %8zu bytes  parse %7.1f MB/s  print %7.1f MB/s\n", BENCH_VARIANT, name, len,
+           len * 1e3 / parse_ns, len * 1e3 / print_ns);
+    cJSON_Delete(c.tree);
+    free(text);
+}
+
+int main(void) {
+    size_t len;
+    char* text = bench_telemetry_corpus(500, &len); // One history page
+    scan_run("telemetry-500", text, len);
+    text = bench_peers_corpus(10, &len); // JW_PEERS_MAX_CAPACITY
+    scan_run("peers-10", text, len);
+    text = bench_peers_corpus(200, &len);
+    scan_run("peers-200", text, len);
+
+    // Long strings, the case the word scanners are for: the SD log tail as one JSON string
+    char* log = bench_log_corpus(500, &len);
+    cJSON* tail = cJSON_CreateObject();
+    cJSON_AddStringToObject(tail, "log", log);
+    text = cJSON_PrintUnformatted(tail);
+    cJSON_Delete(tail);
+    free(log);
+    scan_run("log-tail-500", text, strlen(text));
+    return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef BENCH_STUB_ESP_ERR_H
+#define BENCH_STUB_ESP_ERR_H
+
+// Host stand-ins for the ESP-IDF and FreeRTOS calls jw_server_gzip.c makes (tools/bench), just enough to run it
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef BENCH_STUB_ESP_HEAP_CAPS_H
+#define BENCH_STUB_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+static inline void* heap_caps_malloc(size_t size, unsigned caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+#endif
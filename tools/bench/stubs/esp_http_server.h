@@ -0,0 +1,30 @@
+#ifndef BENCH_STUB_ESP_HTTP_SERVER_H
+#define BENCH_STUB_ESP_HTTP_SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "esp_err.h"
+
+typedef void* httpd_handle_t;
+
+// Chunks go to send_chunk instead of a socket, a NULL/0 chunk is the terminating one
+typedef struct httpd_req {
+    const char* accept_encoding; // Accept-Encoding header, NULL: none
+    esp_err_t (*send_chunk)(struct httpd_req* req, const char* data, size_t len);
+    void* user_ctx;
+} httpd_req_t;
+
+typedef struct httpd_uri {
+    const char* uri;
+    int method;
+    esp_err_t (*handler)(httpd_req_t* req);
+    void* user_ctx;
+} httpd_uri_t;
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t* req, const char* buf, ssize_t buf_len);
+esp_err_t httpd_resp_set_hdr(httpd_req_t* req, const char* field, const char* value);
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t* req, const char* field, char* val, size_t val_size);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef BENCH_STUB_ESP_ROM_CRC_H
+#define BENCH_STUB_ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+// CRC-32 as zlib's crc32() computes it, which is what the ROM function returns: start with 0, chain the results
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
+
+#endif
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "esp_http_server.h"
+#include "esp_rom_crc.h"
+#include "freertos/queue.h"
+#include "jw_log.h"
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t* req, const char* buf, ssize_t buf_len) {
+    return req->send_chunk(req, buf, buf ? (size_t)buf_len : 0);
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t* req, const char* field, const char* value) {
+    (void)req;
+    (void)field;
+    (void)value;
+    return ESP_OK;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t* req, const char* field, char* val, size_t val_size) {
+    if (strcasecmp(field, "Accept-Encoding") != 0 || !req->accept_encoding) return ESP_ERR_NOT_FOUND;
+    if (strlen(req->accept_encoding) >= val_size) return ESP_ERR_INVALID_SIZE;
+    strcpy(val, req->accept_encoding);
+    return ESP_OK;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    }
+    crc = ~crc;
+    while (len--) crc = table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+void jw_log_msg(const char* message) {
+    fprintf(stderr, "jw_log: %s\n", message);
+}
+
+struct bench_queue {
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t items[];
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    QueueHandle_t queue = calloc(1, sizeof(struct bench_queue) + (size_t)length * item_size);
+    if (queue) {
+        queue->length = length;
+        queue->item_size = item_size;
+    }
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait) {
+    (void)wait;
+    if (queue->count == queue->length) return pdFALSE;
+    UBaseType_t slot = (queue->head + queue->count) % queue->length;
+    memcpy(queue->items + (size_t)slot * queue->item_size, item, queue->item_size);
+    queue->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait) {
+    (void)wait;
+    if (queue->count == 0) return pdFALSE;
+    memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return queue->count;
+}
@@ -0,0 +1,14 @@
+#ifndef BENCH_STUB_FREERTOS_H
+#define BENCH_STUB_FREERTOS_H
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define portMAX_DELAY ((TickType_t)0xffffffffu)
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef BENCH_STUB_FREERTOS_QUEUE_H
+#define BENCH_STUB_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+// Single threaded ring buffer, calls never block: a full or empty queue fails at once whatever the timeout
+typedef struct bench_queue* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#endif
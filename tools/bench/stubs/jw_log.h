@@ -0,0 +1,6 @@
+#ifndef BENCH_STUB_JW_LOG_H
+#define BENCH_STUB_JW_LOG_H
+
+void jw_log_msg(const char* message); // Printed to stderr
+
+#endif